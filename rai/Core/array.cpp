@@ -19,6 +19,13 @@
 #include "array.h"
 #include "util.h"
 
+#ifndef RAI_MSVC
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
 #ifdef RAI_LAPACK
 extern "C" {
 #include "cblas.h"
@@ -60,6 +67,7 @@ const bool lapackSupported=false;
 #endif
 int64_t globalMemoryTotal=0, globalMemoryBound=1ull<<32; //this is 1GB
 bool globalMemoryStrict=false;
+bool globalMemoryProfile=false;
 const char* arrayElemsep=", ";
 const char* arrayLinesep=",\n ";
 const char* arrayBrackets="[]";
@@ -1305,6 +1313,85 @@ void scanArrFile(const char* name) {
   }
 }
 
+//===========================================================================
+//
+// memory-mapped binary array files
+//
+
+namespace {
+const char arrayFileMagic[8] = "RAI-ARR";
+const uint32_t arrayFileVersion = 1;
+const uint32_t arrayFileByteOrder = 0x01020304;
+}
+
+uint64_t rai::checksum_fnv1a(const void* data, size_t n) {
+  const unsigned char* c = (const unsigned char*)data;
+  uint64_t h = 0xcbf29ce484222325ull;
+  for(size_t i=0; i<n; i++) { h ^= c[i]; h *= 0x100000001b3ull; }
+  return h;
+}
+
+uint64_t rai::checksum_file(const char* filename) {
+  MappedFile file(filename);
+  return checksum_fnv1a(file.p, file.size);
+}
+
+void rai::writeArrayFile(const char* filename, ArrayFileHeader& head, const void* data) {
+  CHECK(head.alignment && !(head.alignment&(head.alignment-1)), "alignment must be a power of 2");
+  memcpy(head.magic, arrayFileMagic, sizeof(head.magic));
+  head.version = arrayFileVersion;
+  head.byteOrder = arrayFileByteOrder;
+  head.dataOffset = ((sizeof(head)+head.alignment-1)/head.alignment)*head.alignment;
+  head.checksum = checksum_fnv1a(data, head.dataBytes);
+  ofstream os(filename, std::ios::out | std::ios::binary);
+  if(!os.good()) HALT("could not open file `" <<filename <<"' for output");
+  os.write((const char*)&head, sizeof(head));
+  for(uint64_t i=sizeof(head); i<head.dataOffset; i++) os.put(0);
+  os.write((const char*)data, head.dataBytes);
+  if(!os.good()) HALT("could not write file `" <<filename <<"'");
+}
+
+const rai::ArrayFileHeader& rai::checkArrayFile(const MappedFile& file, const char* filename, const char* dtype, uint elemSize, bool verifyChecksum) {
+  if(file.size<sizeof(ArrayFileHeader)) HALT("file `" <<filename <<"' is too short for a binary array file");
+  const ArrayFileHeader& head = *(const ArrayFileHeader*)file.p;
+  if(memcmp(head.magic, arrayFileMagic, sizeof(head.magic))) HALT("file `" <<filename <<"' is not a binary array file");
+  if(head.version!=arrayFileVersion) HALT("binary array file `" <<filename <<"' has version " <<head.version <<" (expected " <<arrayFileVersion <<")");
+  if(head.byteOrder!=arrayFileByteOrder) HALT("binary array file `" <<filename <<"' was written with a different byte order");
+  if(strncmp(head.dtype, dtype, sizeof(head.dtype)) || head.elemSize!=elemSize)
+    HALT("binary array file `" <<filename <<"' holds type '" <<head.dtype <<"' (" <<head.elemSize <<" bytes), not '" <<dtype <<"'");
+  CHECK_LE(head.nd, 8, "corrupt header in `" <<filename <<"'");
+  uint64_t N = head.nd ? 1 : 0;
+  for(uint i=0; i<head.nd; i++) N *= head.dim[i];
+  if(N*elemSize!=head.dataBytes || head.dataOffset%head.alignment || head.dataOffset+head.dataBytes>file.size)
+    HALT("binary array file `" <<filename <<"' is truncated or has an inconsistent header");
+  if(verifyChecksum && checksum_fnv1a(file.p+head.dataOffset, head.dataBytes)!=head.checksum)
+    HALT("checksum mismatch in binary array file `" <<filename <<"'");
+  return head;
+}
+
+#ifndef RAI_MSVC
+rai::MappedFile::MappedFile(const char* filename, bool copyOnWrite) {
+  int fd = ::open(filename, O_RDONLY);
+  if(fd<0) HALT("could not open file `" <<filename <<"': " <<strerror(errno));
+  struct stat st;
+  if(fstat(fd, &st)) { ::close(fd); HALT("could not stat file `" <<filename <<"': " <<strerror(errno)); }
+  size = st.st_size;
+  if(size) {
+    void* addr = mmap(nullptr, size, copyOnWrite ? PROT_READ|PROT_WRITE : PROT_READ, copyOnWrite ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    if(addr==MAP_FAILED) { ::close(fd); HALT("could not map file `" <<filename <<"': " <<strerror(errno)); }
+    p = (char*)addr;
+  }
+  ::close(fd); //the mapping stays valid
+}
+
+rai::MappedFile::~MappedFile() {
+  if(p) munmap(p, size);
+}
+#else
+rai::MappedFile::MappedFile(const char* filename, bool copyOnWrite) { NIY; }
+rai::MappedFile::~MappedFile() {}
+#endif
+
 #ifndef CHECK_EPS
 #  define CHECK_EPS 1e-8
 #endif
@@ -1511,11 +1598,11 @@ rai::String singleString(const StringA& strs) {
 
 #ifdef RAI_LAPACK
 #if 1 //def NO_BLAS
-void blas_MM(arr& X, const arr& A, const arr& B) {       rai::useLapack=false; op_innerProduct(X, A, B); rai::useLapack=true; }
-void blas_MsymMsym(arr& X, const arr& A, const arr& B) { rai::useLapack=false; op_innerProduct(X, A, B); rai::useLapack=true; }
-void blas_Mv(arr& y, const arr& A, const arr& x) {       rai::useLapack=false; op_innerProduct(y, A, x); rai::useLapack=true; }
-void blas_A_At(arr& X, const arr& A) { X = A*~A; }
-void blas_At_A(arr& X, const arr& A) { X = ~A*A; }
+void blas_MM(arr& X, const arr& A, const arr& B) { native_MM(X, A, B); }
+void blas_MsymMsym(arr& X, const arr& A, const arr& B) { native_MM(X, A, B); }
+void blas_Mv(arr& y, const arr& A, const arr& x) { native_Mv(y, A, x); }
+void blas_A_At(arr& X, const arr& A) { native_A_At(X, A); }
+void blas_At_A(arr& X, const arr& A) { native_At_A(X, A); }
 #else
 void blas_MM(arr& X, const arr& A, const arr& B) {
   CHECK_EQ(A.d1, B.d0, "matrix multiplication: wrong dimensions");
@@ -1616,23 +1703,16 @@ arr lapack_Ainv_b_sym(const arr& A, const arr& b) {
     x=~x;
     return x;
   }
-  integer N=A.d0, KD=0, NRHS=1, LDAB=0, INFO;
   if(isRowShifted(A)) {
-    rai::RowShifted* Aaux = (rai::RowShifted*) A.special;
-    if(!Aaux->symmetric) HALT("this is not a symmetric matrix");
-    for(uint i=0; i<A.d0; i++) if(Aaux->rowShift(i)!=i) HALT("this is not shifted as an upper triangle");
-    KD=Aaux->rowSize-1;
-    LDAB=Aaux->rowSize;
+    arr LD;
+    banded_LDLT(LD, A);
+    return banded_LDLT_solve(LD, b);
   }
+  integer N=A.d0, NRHS=1, INFO;
   x=b;
   arr Acol=A;
   try {
-    if(!isRowShifted(A)) {
-      dposv_((char*)"L", &N, &NRHS, Acol.p, &N, x.p, &N, &INFO);
-    } else {
-      //assumes symmetric and upper banded
-      dpbsv_((char*)"L", &N, &KD, &NRHS, Acol.p, &LDAB, x.p, &N, &INFO);
-    }
+    dposv_((char*)"L", &N, &NRHS, Acol.p, &N, x.p, &N, &INFO);
   } catch(...) {
     HALT("here");
   }
@@ -1641,16 +1721,14 @@ arr lapack_Ainv_b_sym(const arr& A, const arr& b) {
     uint k=(N>3?3:N); //number of required eigenvalues
     rai::Array<integer> IWORK(5*N), IFAIL(N);
     arr WORK(10*(3*N)), Acopy=A;
-    integer M, IL=1, IU=k, LDQ=0, LDZ=1, LWORK=WORK.N;
+    integer M, IL=1, IU=k, LDZ=1, LWORK=WORK.N;
     double VL=0., VU=0., ABSTOL=1e-8;
     arr sig(N);
     if(!isSpecial(A)) {
 //      sig.resize(N);
 //      dsyev_ ((char*)"N", (char*)"L", &N, A.p, &N, sig.p, WORK.p, &LWORK, &INFO);
 //      lapack_EigenDecomp(A, sig, NoArr);
-      dsyevx_((char*)"N", (char*)"I", (char*)"L", &N, Acopy.p, &LDAB, &VL, &VU, &IL, &IU, &ABSTOL, &M, sig.p, (double*)nullptr, &LDZ, WORK.p, &LWORK, IWORK.p, IFAIL.p, &INFO);
-    } else if(isRowShifted(A)) {
-      dsbevx_((char*)"N", (char*)"I", (char*)"L", &N, &KD, Acopy.p, &LDAB, (double*)nullptr, &LDQ, &VL, &VU, &IL, &IU, &ABSTOL, &M, sig.p, (double*)nullptr, &LDZ, WORK.p, IWORK.p, IFAIL.p, &INFO);
+      dsyevx_((char*)"N", (char*)"I", (char*)"L", &N, Acopy.p, &N, &VL, &VU, &IL, &IU, &ABSTOL, &M, sig.p, (double*)nullptr, &LDZ, WORK.p, &LWORK, IWORK.p, IFAIL.p, &INFO);
     } else NIY;
     sig.resizeCopy(k);
 //    arr sig, eig;
@@ -1882,11 +1960,11 @@ dlauum = multiply L'*L
 #if !defined RAI_MSVC && defined RAI_NOCHECK
 #  warning "RAI_LAPACK undefined - using inefficient implementations"
 #endif
-void blas_MM(arr& X, const arr& A, const arr& B) { rai::useLapack=false; op_innerProduct(X, A, B); };
-void blas_MsymMsym(arr& X, const arr& A, const arr& B) { rai::useLapack=false; op_innerProduct(X, A, B); };
-void blas_Mv(arr& y, const arr& A, const arr& x) {       rai::useLapack=false; op_innerProduct(y, A, x); rai::useLapack=true; };
-void blas_A_At(arr& X, const arr& A) { NICO }
-void blas_At_A(arr& X, const arr& A) { NICO }
+void blas_MM(arr& X, const arr& A, const arr& B) { native_MM(X, A, B); }
+void blas_MsymMsym(arr& X, const arr& A, const arr& B) { native_MM(X, A, B); }
+void blas_Mv(arr& y, const arr& A, const arr& x) { native_Mv(y, A, x); }
+void blas_A_At(arr& X, const arr& A) { native_A_At(X, A); }
+void blas_At_A(arr& X, const arr& A) { native_At_A(X, A); }
 void lapack_cholesky(arr& C, const arr& A) { NICO }
 void lapack_choleskySymPosDef(arr& Achol, const arr& A) { NICO }
 uint lapack_SVD(arr& U, arr& d, arr& Vt, const arr& A) { NICO; }
@@ -1897,6 +1975,11 @@ bool lapack_isPositiveSemiDefinite(const arr& symmA) { NICO; }
 void lapack_inverseSymPosDef(arr& Ainv, const arr& A) { NICO; }
 arr lapack_kSmallestEigenValues_sym(const arr& A, uint k) { NICO; }
 arr lapack_Ainv_b_sym(const arr& A, const arr& b) {
+  if(isRowShifted(A)) {
+    arr LD;
+    banded_LDLT(LD, A);
+    return banded_LDLT_solve(LD, b);
+  }
   arr invA;
   inverse(invA, A);
   return invA*b;
@@ -1907,6 +1990,58 @@ arr lapack_Ainv_b_symPosDef_givenCholesky(const arr& U, const arr& b) { return i
 arr lapack_Ainv_b_triangular(const arr& L, const arr& b) { return inverse(L)*b; }
 #endif
 
+//===========================================================================
+//
+// banded LDL^T
+//
+
+/// LDL^T of a symmetric banded matrix in RowShifted storage (row i holds A(i,i..i+w-1)): LD(i,0)=D(i), LD(i,j)=U(i,i+j) of the unit upper factor U=L^T
+void banded_LDLT(arr& LD, const arr& A) {
+  CHECK(isRowShifted(A), "");
+  const rai::RowShifted& S = A.rowShifted();
+  if(!S.symmetric) HALT("this is not a symmetric matrix");
+  for(uint i=0; i<A.d0; i++) if(S.rowShift(i)!=i) HALT("this is not shifted as an upper triangle");
+  uint n=A.d0, w=S.rowSize;
+  LD = S.memRef();
+  if(!w) THROW("banded_LDLT: matrix is zero");
+
+  for(uint i=0; i<n; i++) {
+    double* __restrict Li = LD.p+i*w;
+    double d = Li[0];
+    if(!(d>0.)) THROW("banded_LDLT: matrix is not positive definite (D(" <<i <<")=" <<d <<")");
+    uint m = rai::MIN(w, n-i); //band width left at the end of the matrix
+    //rank-1 update of the trailing band: A(i+j, i+k) -= A(i,i+j) A(i,i+k) / d
+    for(uint j=1; j<m; j++) {
+      double f = Li[j]/d;
+      if(f==0.) continue;
+      double* __restrict Lj = LD.p+(i+j)*w - j;
+      for(uint k=j; k<m; k++) Lj[k] -= f*Li[k]; //contiguous in both rows: vectorizes
+    }
+    for(uint j=1; j<m; j++) Li[j] /= d;
+  }
+}
+
+arr banded_LDLT_solve(const arr& LD, const arr& b) {
+  uint n=LD.d0, w=LD.d1;
+  CHECK_EQ(b.N, n, "");
+  arr x = b;
+  for(uint i=0; i<n; i++) { //U^T y = b
+    const double* Li = LD.p+i*w;
+    double xi = x.p[i];
+    uint m = rai::MIN(w, n-i);
+    for(uint j=1; j<m; j++) x.p[i+j] -= Li[j]*xi;
+  }
+  for(uint i=0; i<n; i++) x.p[i] /= LD.p[i*w];
+  for(uint i=n; i--;) { //U x = z
+    const double* Li = LD.p+i*w;
+    double xi = x.p[i];
+    uint m = rai::MIN(w, n-i);
+    for(uint j=1; j<m; j++) xi -= Li[j]*x.p[i+j];
+    x.p[i] = xi;
+  }
+  return x;
+}
+
 //===========================================================================
 //
 // Eigen
@@ -2390,6 +2525,7 @@ SparseMatrix& SparseMatrix::resize(uint d0, uint d1, uint n) {
   Z.setZero();
   elems.resize(n, 2);
   for(int& e:elems) e=-1;
+  clearCompressed();
   return *this;
 }
 
@@ -2401,10 +2537,13 @@ void SparseMatrix::resizeCopy(uint d0, uint d1, uint n) {
   elems.resizeCopy(n, 2);
 //  for(uint i=Nold; i<n; i++) elems(i, 0) = elems(i, 1) =-1;
   for(int *p=elems.p+2*Nold, *pstop=elems.p+2*n; p<pstop; p++) *p = -1;
+  clearCompressed();
 }
 
 void SparseMatrix::reshape(uint d0, uint d1) {
   Z.nd=2; Z.d0=d0; Z.d1=d1;
+  if(rows.nd){ rows.clear(); cols.clear(); }
+  clearCompressed();
 }
 
 double& SparseVector::entry(uint i, uint k) {
@@ -2424,6 +2563,7 @@ double& SparseMatrix::entry(uint i, uint j, uint k) {
     elemsk[0]=i;
     elemsk[1]=j;
     if(rows.nd){ rows.clear(); cols.clear(); }
+    if(csrStart.N) clearCompressed();
   } else {
     CHECK_EQ(elemsk[0], (int)i, "");
     CHECK_EQ(elemsk[1], (int)j, "");
@@ -2471,6 +2611,7 @@ double& SparseMatrix::addEntry(int i, int j) {
   elems(k, 0)=i;
   elems(k, 1)=j;
   if(rows.nd){ rows.clear(); cols.clear(); }
+  if(csrStart.N) clearCompressed();
   Z.resizeMEM(k+1, true);
   Z.last()=0.;
   return Z.last();
@@ -2544,6 +2685,43 @@ void SparseMatrix::setFromDense(const arr& X) {
     }
 }
 
+void SparseMatrix::setFromTriplets(const arr& T, uint d0, uint d1) {
+  CHECK(T.nd==2 && T.d1==3, "triplets need to be a (n,3) array of (row,col,value)");
+  resize(d0, d1, T.d0);
+  for(uint k=0; k<T.d0; k++) entry(T.p[3*k], T.p[3*k+1], k) = T.p[3*k+2];
+}
+
+/// counting sort of the non-zeros by row and by column (stable: memory order within each row/column); the index is
+/// kept until a mutator of elems (entry, addEntry, resize, rowShift, add, ...) calls clearCompressed
+void SparseMatrix::setupCompressed() const {
+  if(csrStart.N==Z.d0+1 && cscStart.N==Z.d1+1 && csrMem.N==Z.N) return;
+  CHECK_EQ(elems.N, 2*Z.N, "");
+  csrStart.resize(Z.d0+1).setZero();
+  cscStart.resize(Z.d1+1).setZero();
+  for(uint k=0; k<Z.N; k++) {
+    int i=elems.p[2*k], j=elems.p[2*k+1];
+    CHECK(i>=0 && j>=0 && (uint)i<Z.d0 && (uint)j<Z.d1, "non-zero " <<k <<" has no valid index (" <<i <<',' <<j <<") in " <<Z.d0 <<'x' <<Z.d1);
+    csrStart.p[i+1]++; cscStart.p[j+1]++;
+  }
+  for(uint i=0; i<Z.d0; i++) csrStart.p[i+1] += csrStart.p[i];
+  for(uint j=0; j<Z.d1; j++) cscStart.p[j+1] += cscStart.p[j];
+  csrCol.resize(Z.N);  csrMem.resize(Z.N);
+  cscRow.resize(Z.N);  cscMem.resize(Z.N);
+  uintA r = csrStart, c = cscStart; //insertion positions
+  for(uint k=0; k<Z.N; k++) {
+    uint i=elems.p[2*k], j=elems.p[2*k+1];
+    uint l = r.p[i]++;
+    csrCol.p[l]=j;  csrMem.p[l]=k;
+    l = c.p[j]++;
+    cscRow.p[l]=i;  cscMem.p[l]=k;
+  }
+}
+
+void SparseMatrix::clearCompressed() {
+  csrStart.clear(); csrCol.clear(); csrMem.clear();
+  cscStart.clear(); cscRow.clear(); cscMem.clear();
+}
+
 void SparseMatrix::setupRowsCols() {
   rows.resize(Z.d0);
   cols.resize(Z.d1);
@@ -2559,6 +2737,7 @@ void SparseMatrix::setupRowsCols() {
 
 void SparseMatrix::rowShift(int shift) {
   if(rows.nd){ rows.clear(); cols.clear(); }
+  clearCompressed();
   for(uint i=0; i<elems.d0; i++) {
     int& j = elems(i, 1);
     CHECK_GE(j+shift, 0, "");
@@ -2569,6 +2748,7 @@ void SparseMatrix::rowShift(int shift) {
 
 void SparseMatrix::colShift(int shift) {
   if(rows.nd){ rows.clear(); cols.clear(); }
+  clearCompressed();
   for(uint i=0; i<elems.d0; i++) {
     int& j = elems.p[2*i]; //(i, 0);
     CHECK_GE(j+shift, 0, "");
@@ -2577,26 +2757,70 @@ void SparseMatrix::colShift(int shift) {
   }
 }
 
-#ifdef RAI_EIGEN
+arr SparseMatrix::A_x(const arr& x) const {
+  CHECK_EQ(x.N, Z.d1, "");
+  setupCompressed();
+  arr y(Z.d0);
+  for(uint i=0; i<Z.d0; i++) {
+    double yi=0.;
+    for(uint l=csrStart.p[i]; l<csrStart.p[i+1]; l++) yi += Z.p[csrMem.p[l]] * x.p[csrCol.p[l]];
+    y.p[i] = yi;
+  }
+  return y;
+}
 
 arr SparseMatrix::At_x(const arr& x) {
-  Eigen::SparseMatrix<double> A_eig = conv_sparseArr2sparseEigen(*this);
-  Eigen::MatrixXd x_eig = conv_arr2eigen(x);
-
-  x_eig = A_eig.transpose() * x_eig;
-
-  arr y(x_eig.rows());
-  for(uint i = 0; i<y.d0; i++) y(i) = x_eig(i, 0);
+  CHECK_EQ(x.N, Z.d0, "");
+  setupCompressed();
+  arr y(Z.d1);
+  for(uint j=0; j<Z.d1; j++) {
+    double yj=0.;
+    for(uint l=cscStart.p[j]; l<cscStart.p[j+1]; l++) yj += Z.p[cscMem.p[l]] * x.p[cscRow.p[l]];
+    y.p[j] = yj;
+  }
   return y;
 }
 
-arr SparseMatrix::At_A() {
-  Eigen::SparseMatrix<double> s = conv_sparseArr2sparseEigen(*this);
+/// the rows of a compressed sparse matrix (or, for the CSC index, the rows of its transpose)
+struct CompressedRows {
+  const uintA& start, & idx, & mem;
+  const double* val;
+};
 
-  Eigen::SparseMatrix<double> W(Z.d1, Z.d1);
-  W = s.transpose() * s;
+/// Gustavson's row-by-row product C = A*B with a dense accumulator; the columns of each row of C are sorted
+static arr sparseProduct(const CompressedRows& A, const CompressedRows& B, uint d0, uint d1) {
+  arr acc(d1);
+  intA mark(d1);
+  mark = -1;
+  uintA rowCols, Ci, Cj;
+  arr Cv;
+  for(uint i=0; i<d0; i++) {
+    rowCols.clear();
+    for(uint la=A.start.p[i]; la<A.start.p[i+1]; la++) {
+      uint k = A.idx.p[la];
+      double a = A.val[A.mem.p[la]];
+      for(uint lb=B.start.p[k]; lb<B.start.p[k+1]; lb++) {
+        uint j = B.idx.p[lb];
+        if(mark.p[j]!=(int)i) { mark.p[j]=i; acc.p[j]=0.; rowCols.append(j); }
+        acc.p[j] += a * B.val[B.mem.p[lb]];
+      }
+    }
+    std::sort(rowCols.p, rowCols.p+rowCols.N);
+    for(uint j:rowCols) { Ci.append(i); Cj.append(j); Cv.append(acc.p[j]); }
+  }
 
-  return conv_sparseEigen2sparseArr(W);
+  arr C;
+  SparseMatrix& S = C.sparse();
+  S.resize(d0, d1, Cv.N);
+  if(Cv.N) memmove(C.p, Cv.p, Cv.N*sizeof(double));
+  for(uint k=0; k<Cv.N; k++) { S.elems.p[2*k]=Ci.p[k]; S.elems.p[2*k+1]=Cj.p[k]; }
+  return C;
+}
+
+arr SparseMatrix::At_A() {
+  setupCompressed();
+  //row j of A^T A: sum over the non-zeros (i,j) of column j of A times row i of A
+  return sparseProduct({cscStart, cscRow, cscMem, Z.p}, {csrStart, csrCol, csrMem, Z.p}, Z.d1, Z.d1);
 }
 
 arr SparseMatrix::A_B(const arr& B) const {
@@ -2614,13 +2838,13 @@ arr SparseMatrix::A_B(const arr& B) const {
     CHECK_EQ(l, C.N, "");
     return C;
   }
-  Eigen::SparseMatrix<double> A_eig = conv_sparseArr2sparseEigen(*this);
-  Eigen::SparseMatrix<double> B_eig = conv_sparseArr2sparseEigen(B.copy().sparse());
-//  Eigen::MatrixXd B_eig = conv_arr2eigen(B);
-
-  Eigen::SparseMatrix<double> W = A_eig * B_eig;
-
-  return conv_sparseEigen2sparseArr(W);
+  arr Bsparse;
+  if(!isSparseMatrix(B)) Bsparse.sparse().setFromDense(B);
+  const SparseMatrix& Bs = (isSparseMatrix(B) ? B.sparse() : Bsparse.sparse());
+  CHECK_EQ(Z.d1, Bs.Z.d0, "");
+  setupCompressed();
+  Bs.setupCompressed();
+  return sparseProduct({csrStart, csrCol, csrMem, Z.p}, {Bs.csrStart, Bs.csrCol, Bs.csrMem, Bs.Z.p}, Z.d0, Bs.Z.d1);
 }
 
 arr SparseMatrix::B_A(const arr& B) const {
@@ -2639,23 +2863,15 @@ arr SparseMatrix::B_A(const arr& B) const {
 //    S.resizeCopy(B.d0, Z.d1, l);
     return C;
   }
-  Eigen::SparseMatrix<double> A_eig = conv_sparseArr2sparseEigen(*this);
-  Eigen::SparseMatrix<double> B_eig = conv_sparseArr2sparseEigen(B.copy().sparse());
-
-  Eigen::SparseMatrix<double> W = B_eig * A_eig;
-
-  return conv_sparseEigen2sparseArr(W);
+  arr Bsparse;
+  if(!isSparseMatrix(B)) Bsparse.sparse().setFromDense(B);
+  const SparseMatrix& Bs = (isSparseMatrix(B) ? B.sparse() : Bsparse.sparse());
+  CHECK_EQ(Bs.Z.d1, Z.d0, "");
+  setupCompressed();
+  Bs.setupCompressed();
+  return sparseProduct({Bs.csrStart, Bs.csrCol, Bs.csrMem, Bs.Z.p}, {csrStart, csrCol, csrMem, Z.p}, Bs.Z.d0, Z.d1);
 }
 
-#else //RAI_EIGEN
-
-arr SparseMatrix::At_x(const arr& x) { NICO }
-arr SparseMatrix::At_A() { NICO }
-arr SparseMatrix::A_B(const arr& B) const { NICO }
-arr SparseMatrix::B_A(const arr& B) const { NICO }
-
-#endif //RAI_EIGEN
-
 void SparseMatrix::transpose() {
   uint d0 = Z.d0;
   Z.d0 = Z.d1;
@@ -2666,6 +2882,7 @@ void SparseMatrix::transpose() {
     elems(i, 1) = k;
   }
   if(rows.nd){ cols.clear(); rows.clear(); }
+  clearCompressed();
 }
 
 void SparseMatrix::rowWiseMult(const arr& a) {
@@ -2696,6 +2913,8 @@ void SparseMatrix::add(const SparseMatrix& a, uint lo0, uint lo1, double coeff){
   CHECK_LE(lo0+a.Z.d0, Z.d0, "");
   CHECK_LE(lo1+a.Z.d1, Z.d1, "");
   if(!a.Z.N) return; //nothing to add
+  if(rows.nd){ rows.clear(); cols.clear(); }
+  clearCompressed();
   uint Nold=Z.N;
 #if 1
   Z.resizeMEM(Nold+a.Z.N, true);
@@ -2730,6 +2949,8 @@ void SparseMatrix::add(const arr& B, uint lo0, uint lo1, double coeff){
   }else if(B.nd==1){ //add a row vector
     CHECK_LE(lo1+B.d0, Z.d1, "");
   }else NIY;
+  if(rows.nd){ rows.clear(); cols.clear(); }
+  clearCompressed();
   uint Nold=Z.N;
   Z.resizeMEM(Nold+B.N, true);
   memmove(Z.p+Nold, B.p, Z.sizeT*B.N);
@@ -2849,8 +3070,7 @@ arr rai::unpack(const arr& X) {
 arr rai::comp_At_A(const arr& A) {
   if(!isSpecial(A)) {
     arr X;
-    if(rai::useLapack) blas_At_A(X, A);
-    else X = ~A * A;
+    blas_At_A(X, A);
     return X;
   }
   if(isRowShifted(A)) return dynamic_cast<rai::RowShifted*>(A.special)->At_A();
@@ -2871,7 +3091,12 @@ arr rai::comp_A_At(const arr& A) {
 //}
 
 arr rai::comp_At_x(const arr& A, const arr& x) {
-  if(!isSpecial(A)) { arr y; op_innerProduct(y, ~A, x); return y; }
+  if(!isSpecial(A)) {
+    arr y;
+    if(A.nd==2 && x.nd==1) native_At_x(y, A, x);
+    else op_innerProduct(y, ~A, x);
+    return y;
+  }
   if(isRowShifted(A)) return ((rai::RowShifted*)A.special)->At_x(x);
   if(isSparseMatrix(A)) return ((rai::SparseMatrix*)A.special)->At_x(x);
   return NoArr;
@@ -2886,6 +3111,7 @@ arr rai::comp_At(const arr& A) {
 arr rai::comp_A_x(const arr& A, const arr& x) {
   if(!isSpecial(A)) { arr y; op_innerProduct(y, A, x); return y; }
   if(isRowShifted(A)) return ((rai::RowShifted*)A.special)->A_x(x);
+  if(isSparseMatrix(A)) return ((rai::SparseMatrix*)A.special)->A_x(x);
   return NoArr;
 }
 
@@ -14,6 +14,7 @@
 #include <functional>
 #include <memory>
 #include <vector>
+#include <type_traits>
 
 #define ARR ARRAY<double> ///< write ARR(1., 4., 5., 7.) to generate a double-Array
 #define TUP ARRAY<uint> ///< write TUP(1, 2, 3) to generate a uint-Array
@@ -43,6 +44,14 @@ extern const bool lapackSupported;
 extern int64_t globalMemoryTotal, globalMemoryBound;
 extern bool globalMemoryStrict;
 
+// allocation profiling (memprofile.cpp): when globalMemoryProfile is set (e.g. by the environment variable
+// RAI_MEMPROFILE, which also prints the report at exit), resizeMEM/freeMEM record allocations per call site and type
+extern bool globalMemoryProfile;
+void memoryProfile_alloc(void* p, uint64_t bytes, const char* type);
+void memoryProfile_free(void* p);
+void memoryProfileReport(std::ostream& os=std::cerr, uint top=20);
+void memoryProfileReset();
+
 // default write formatting
 extern const char* arrayElemsep;
 extern const char* arrayLinesep;
@@ -83,6 +92,8 @@ template<class T> struct Array : /*std::vector<T>,*/ Serializable {
   uint d0, d1, d2; ///< 0th, 1st, 2nd dim
   uint* d;  ///< pointer to dimensions (for nd<=3 points to d0)
   bool isReference; ///< true if this refers to memory of another array
+  unsigned char inlineM;       ///< capacity of the inline buffer of a SmallArray (0: plain array)
+  unsigned short inlineOffset; ///< byte offset of that buffer from this
   uint M;   ///< memory allocated (>=N)
 
   static int  sizeT;   ///< constant for each type T: stores the sizeof(T)
@@ -112,6 +123,7 @@ template<class T> struct Array : /*std::vector<T>,*/ Serializable {
   Array<T>& operator=(std::initializer_list<T> values);
   Array<T>& operator=(const T& v);
   Array<T>& operator=(const Array<T>& a);
+  Array<T>& operator=(Array<T>&& a); ///< steals the memory of plain arrays unless the own buffer fits; copies for references and specials
   Array<T>& operator=(const std::vector<T>& values);
 
   /// @name iterators
@@ -326,6 +338,10 @@ template<class T> struct Array : /*std::vector<T>,*/ Serializable {
 
   /// @name kind of private
   void resizeMEM(uint n, bool copy, int Mforce=-1);
+  T* inlineBuffer() const { return (T*)((char*)this+inlineOffset); }
+  bool isInline() const { return inlineM && p==inlineBuffer(); }
+  uint inlineCapacity() const { return inlineM; }
+  void leaveInline();
   void reserveMEM(uint Mforce) { resizeMEM(N, true, Mforce); if(!nd) nd=1; }
   void freeMEM();
   void resetD();
@@ -336,6 +352,28 @@ template<class T> struct Array : /*std::vector<T>,*/ Serializable {
   uint serial_decode(char* data, uint data_size);
 };
 
+//===========================================================================
+
+/** An Array of an elementary type that keeps up to n elements in an inline buffer instead of on the heap, e.g. for
+    small temporaries in hot loops. Unlike for plain Arrays, moving or swapping it invalidates references into its data. */
+template<class T, uint n=16> struct SmallArray : Array<T> {
+  alignas(16) char buffer[n*sizeof(T)];
+
+  SmallArray() {
+    static_assert(std::is_arithmetic<T>::value && n<256, "inline storage only for up to 255 elementary elements");
+    this->inlineM = n;
+    this->inlineOffset = buffer-(char*)this;
+  }
+  SmallArray(const SmallArray& a) : SmallArray() { Array<T>::operator=(a); }
+  SmallArray(SmallArray&& a) : SmallArray() { Array<T>::operator=(std::move(a)); }
+  SmallArray(const Array<T>& a) : SmallArray() { Array<T>::operator=(a); }
+  SmallArray(Array<T>&& a) : SmallArray() { Array<T>::operator=(std::move(a)); }
+  SmallArray(std::initializer_list<T> values) : SmallArray() { Array<T>::operator=(values); }
+  SmallArray& operator=(const SmallArray& a) { Array<T>::operator=(a); return *this; }
+  SmallArray& operator=(SmallArray&& a) { Array<T>::operator=(std::move(a)); return *this; }
+  using Array<T>::operator=;
+};
+
 //===========================================================================
 ///
 /// @name alternative iterators
@@ -444,6 +482,21 @@ BinaryOperator(-, -=);
 //BinaryOperator(/ , /=);
 #undef BinaryOperator
 
+//element-wise operators on temporaries: update the temporary in place, so that chains like 2.*A + B - c*D
+//evaluate in single loops over one buffer without intermediate allocations (references are never overwritten)
+template<class T> Array<T> operator+(Array<T>&& y, const Array<T>& z);
+template<class T> Array<T> operator+(const Array<T>& y, Array<T>&& z);
+template<class T> Array<T> operator+(Array<T>&& y, Array<T>&& z);
+template<class T> Array<T> operator+(Array<T>&& y, T z);
+template<class T> Array<T> operator+(T y, Array<T>&& z);
+template<class T> Array<T> operator-(Array<T>&& y, const Array<T>& z);
+template<class T> Array<T> operator-(Array<T>&& y, T z);
+template<class T> Array<T> operator-(Array<T>&& y);
+template<class T> Array<T> operator*(Array<T>&& y, T z);
+template<class T> Array<T> operator*(T y, Array<T>&& z);
+template<class T> Array<T> operator/(Array<T>&& y, T z);
+template<class T> Array<T> operator/(Array<T>&& y, const Array<T>& z);
+
 /// @} //name
 } //namespace
 
@@ -798,6 +851,58 @@ template<class T> rai::Array<T> elemWisemax(const rai::Array<T>& x, const T& y);
 template<class T> rai::Array<T> elemWisemax(const T& x, const rai::Array<T>& y);
 template<class T> rai::Array<T> elemWiseHinge(const rai::Array<T>& x);
 
+//===========================================================================
+/// @}
+/// @name vectorized kernels on raw memory
+/// @{
+
+/** used by the reductions and element-wise operators above; the double and float versions (simd.cpp) are
+ *  dispatched at load time to the widest ISA available (AVX-512, AVX2, SSE2), reductions have a fixed lane
+ *  order and return the same result on every ISA */
+namespace rai {
+namespace simd {
+template<class T> T sum(const T* x, uint n);
+template<class T> T sumOfSqr(const T* x, uint n);
+template<class T> T sumOfAbs(const T* x, uint n);
+template<class T> T sumOfPos(const T* x, uint n);
+template<class T> T absMax(const T* x, uint n);
+template<class T> T scalarProduct(const T* x, const T* y, uint n);
+template<class T> T sqrDistance(const T* x, const T* y, uint n);
+template<class T> void add(T* x, const T* y, uint n); ///< x += y
+template<class T> void sub(T* x, const T* y, uint n);
+template<class T> void mul(T* x, const T* y, uint n);
+template<class T> void div(T* x, const T* y, uint n);
+template<class T> void add(T* x, T y, uint n);        ///< x += y for all elements
+template<class T> void sub(T* x, T y, uint n);
+template<class T> void mul(T* x, T y, uint n);
+template<class T> void div(T* x, T y, uint n);
+template<class T> void min(T* z, const T* x, const T* y, uint n); ///< z = element-wise min(x, y)
+template<class T> void max(T* z, const T* x, const T* y, uint n);
+
+#define RAI_SIMD_DECL(T) \
+  T sum(const T* x, uint n); \
+  T sumOfSqr(const T* x, uint n); \
+  T sumOfAbs(const T* x, uint n); \
+  T sumOfPos(const T* x, uint n); \
+  T absMax(const T* x, uint n); \
+  T scalarProduct(const T* x, const T* y, uint n); \
+  T sqrDistance(const T* x, const T* y, uint n); \
+  void add(T* x, const T* y, uint n); \
+  void sub(T* x, const T* y, uint n); \
+  void mul(T* x, const T* y, uint n); \
+  void div(T* x, const T* y, uint n); \
+  void add(T* x, T y, uint n); \
+  void sub(T* x, T y, uint n); \
+  void mul(T* x, T y, uint n); \
+  void div(T* x, T y, uint n); \
+  void min(T* z, const T* x, const T* y, uint n); \
+  void max(T* z, const T* x, const T* y, uint n);
+RAI_SIMD_DECL(double)
+RAI_SIMD_DECL(float)
+#undef RAI_SIMD_DECL
+}
+}
+
 template<class T> void writeConsecutiveConstant(std::ostream& os, const rai::Array<T>& x);
 
 //===========================================================================
@@ -891,6 +996,52 @@ bool samedim(const rai::Array<T>& a, const rai::Array<S>& b) {
   return (b.nd==a.nd && b.d0==a.d0 && b.d1==a.d1 && b.d2==a.d2);
 }
 
+//===========================================================================
+/// @}
+/// @name memory-mapped binary array files
+/// @{
+
+namespace rai {
+
+/// header of a binary array file (version 1); the raw data follows at dataOffset, a multiple of alignment
+struct ArrayFileHeader {
+  char magic[8];       ///< "RAI-ARR"
+  uint32_t version;
+  uint32_t byteOrder;  ///< 0x01020304 as stored by the writing host
+  char dtype[16];      ///< "f8", "i4", "u1", etc., or the typeid name for other POD types
+  uint32_t elemSize;
+  uint32_t nd;
+  uint64_t dim[8];
+  uint64_t alignment;
+  uint64_t dataOffset;
+  uint64_t dataBytes;
+  uint64_t checksum;   ///< FNV-1a of the data bytes
+};
+
+/// a whole file mapped into memory, read-only and shared, or private copy-on-write; unmapped on destruction
+struct MappedFile {
+  char* p=0;
+  size_t size=0;
+  MappedFile(const char* filename, bool copyOnWrite=false);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+};
+
+uint64_t checksum_fnv1a(const void* data, size_t n);
+uint64_t checksum_file(const char* filename); ///< FNV-1a of the file content
+void writeArrayFile(const char* filename, ArrayFileHeader& head, const void* data);
+const ArrayFileHeader& checkArrayFile(const MappedFile& file, const char* filename, const char* dtype, uint elemSize, bool verifyChecksum);
+
+template<class T> std::string arrayDtype();
+/// writes x (a POD-typed array) as binary array file, with data aligned to 'alignment' bytes
+template<class T> void writeArrayFile(const Array<T>& x, const char* filename, uint alignment=64);
+/** maps the file and lets x refer to the data (O(1), pages are loaded lazily on access and shared among processes);
+  x is only valid while the returned handle lives; unless copyOnWrite, the data must not be modified */
+template<class T> std::shared_ptr<MappedFile> mapArrayFile(Array<T>& x, const char* filename, bool verifyChecksum=false, bool copyOnWrite=false);
+
+}
+
 //===========================================================================
 /// @}
 /// @name low-level lapack interfaces
@@ -902,6 +1053,13 @@ void blas_MsymMsym(arr& X, const arr& A, const arr& B);
 void blas_A_At(arr& X, const arr& A);
 void blas_At_A(arr& X, const arr& A);
 
+//built-in cache-blocked kernels (gemm.cpp), used by the blas_* wrappers when no BLAS is linked
+void native_MM(arr& X, const arr& A, const arr& B);
+void native_Mv(arr& y, const arr& A, const arr& x);
+void native_A_At(arr& X, const arr& A);
+void native_At_A(arr& X, const arr& A);
+void native_At_x(arr& y, const arr& A, const arr& x);
+
 void lapack_cholesky(arr& C, const arr& A);
 uint lapack_SVD(arr& U, arr& d, arr& Vt, const arr& A);
 void lapack_mldivide(arr& X, const arr& A, const arr& B);
@@ -918,6 +1076,8 @@ arr lapack_Ainv_b_sym(const arr& A, const arr& b);
 void lapack_min_Ax_b(arr& x, const arr& A, const arr& b);
 arr lapack_Ainv_b_symPosDef_givenCholesky(const arr& U, const arr& b);
 arr lapack_Ainv_b_triangular(const arr& L, const arr& b);
+void banded_LDLT(arr& LD, const arr& A);
+arr banded_LDLT_solve(const arr& LD, const arr& b);
 arr eigen_Ainv_b(const arr& A, const arr& b);
 
 //===========================================================================
@@ -1013,6 +1173,9 @@ struct SparseMatrix : SpecialArray {
   intA elems;  ///< for every non-zero (in memory order), the (row,col) index tuple
   uintAA cols; ///< for every column, for every non-zero the (row,memory) index tuple
   uintAA rows; ///< for every row   , for every non-zero the (column,memory) index tuple
+  //compressed row (CSR) and column (CSC) index of elems; built on demand, cleared by every mutator of elems (direct writes to elems need clearCompressed())
+  mutable uintA csrStart, csrCol, csrMem; ///< row i has the non-zeros [csrStart(i),csrStart(i+1)), with column csrCol(k) and value Z(csrMem(k))
+  mutable uintA cscStart, cscRow, cscMem; ///< column j has the non-zeros [cscStart(j),cscStart(j+1)), with row cscRow(k) and value Z(cscMem(k))
 
   SparseMatrix(arr& _Z);
   SparseMatrix(arr& _Z, const SparseMatrix& s);
@@ -1024,7 +1187,10 @@ struct SparseMatrix : SpecialArray {
   arr memRef() const{ return arr(Z.p, Z.N, true); }
   //construction
   void setFromDense(const arr& X);
+  void setFromTriplets(const arr& T, uint d0, uint d1);
   void setupRowsCols();
+  void setupCompressed() const;
+  void clearCompressed();
   //manipulations
   SparseMatrix& resize(uint d0, uint d1, uint n);
   void resizeCopy(uint d0, uint d1, uint n);
@@ -1032,6 +1198,7 @@ struct SparseMatrix : SpecialArray {
   void rowShift(int shift); //shift all rows to the right
   void colShift(int shift); //shift all cols downward
   //computations
+  arr A_x(const arr& x) const;
   arr At_x(const arr& x);
   arr At_A();
   arr A_B(const arr& B) const;
@@ -61,6 +61,7 @@ template<class T> rai::Array<T>::Array()
     d0(0), d1(0), d2(0),
     d(&d0),
     isReference(false),
+    inlineM(0), inlineOffset(0),
     M(0),
     special(0) {
   if(sizeT==-1) sizeT=sizeof(T);
@@ -92,12 +93,14 @@ template<class T> rai::Array<T>::Array(rai::Array<T>&& a)
     d0(a.d0), d1(a.d1), d2(a.d2),
     d(&d0),
     isReference(a.isReference),
+    inlineM(0), inlineOffset(0),
     M(a.M),
     special(a.special){
   if(a.jac) jac = std::move(a.jac);
   CHECK_EQ(a.d, &a.d0, "");
+  if(a.isInline()) { a.leaveInline(); p=a.p; M=a.M; } //inline storage can't be stolen
   a.p=NULL;
-  a.N=a.nd=a.d0=a.d1=a.d2=0;
+  a.N=a.nd=a.d0=a.d1=a.d2=a.M=0;
   a.isReference=false;
   a.special=NULL;
 }
@@ -452,6 +455,36 @@ template<class T> void rai::Array<T>::resizeMEM(uint n, bool copy, int Mforce) {
     }
   }
 
+#ifndef RAI_USE_STDVEC
+  //-- small arrays: use the inline buffer instead of the heap
+  uint Minline = inlineCapacity();
+  if(Mnew<=Minline && (n || isInline())) {
+    if(!isInline()) {
+      if(p) {
+        memmove(inlineBuffer(), p, sizeT*(N<n?N:n));
+        globalMemoryTotal -= Mold*sizeT;
+        if(globalMemoryProfile) memoryProfile_free(p);
+        free(p);
+      }
+      p=inlineBuffer();
+      M=Minline;
+    }
+    N=n;
+    return;
+  }
+  if(isInline()) { //from the inline buffer to the heap
+    T* pnew = (T*)malloc(Mnew*sizeT);
+    if(!pnew) { HALT("memory allocation failed! Wanted size = " <<Mnew*sizeT <<"bytes"); }
+    memmove(pnew, p, sizeT*(N<n?N:n));
+    globalMemoryTotal += Mnew*sizeT;
+    if(globalMemoryProfile) memoryProfile_alloc(pnew, Mnew*sizeT, typeid(T).name());
+    p=pnew;
+    M=Mnew;
+    N=n;
+    return;
+  }
+#endif
+
 #ifdef RAI_USE_STDVEC
   if(Mnew!=Mold){ vec_type::resize(Mnew); }
 //  vec_type::reserve(Mnew);
@@ -470,6 +503,7 @@ template<class T> void rai::Array<T>::resizeMEM(uint n, bool copy, int Mforce) {
       }
       LOG(0) <<"using massive memory: " <<(globalMemoryTotal>>20) <<"MB";
     }
+    if(globalMemoryProfile && p) memoryProfile_free(p);
     if(Mnew) {
       if(memMove==1){
         if(p){
@@ -487,6 +521,7 @@ template<class T> void rai::Array<T>::resizeMEM(uint n, bool copy, int Mforce) {
         if(pold) delete[] pold;
       }
       M=Mnew;
+      if(globalMemoryProfile) memoryProfile_alloc(p, Mnew*sizeT, typeid(T).name());
     } else {
       if(p) {
         if(memMove==1){
@@ -509,8 +544,13 @@ template<class T> void rai::Array<T>::freeMEM() {
 #ifdef RAI_USE_STDVEC
   vec_type::clear();
 #else
+  if(M && isInline()) {
+    p=0;
+    M=0;
+  }
   if(M) {
     rai::globalMemoryTotal -= M*sizeT;
+    if(globalMemoryProfile) memoryProfile_free(p);
     if(memMove==1){
       free(p);
     }else{
@@ -1375,6 +1415,19 @@ template<class T> rai::Array<T>& rai::Array<T>::operator=(const rai::Array<T>& a
   return *this;
 }
 
+/// move operator: steals a's memory only where the copy would reallocate anyway -- if the own buffer can hold a, it is
+/// copied in place, so that references into this array (referTo, subarrays) stay valid as with the copy operator;
+/// the inline data of a SmallArray is copied as well
+template<class T> rai::Array<T>& rai::Array<T>::operator=(rai::Array<T>&& a) {
+  if(isReference || special || nd>3 || a.isReference || a.special || a.nd>3) return operator=((const Array<T>&)a);
+  if(a.isInline() || (M && a.N<=M) || a.N<=inlineCapacity()) return operator=((const Array<T>&)a);
+  CHECK(this!=&a, "never do this!!!");
+  swap(a);
+  a.clear();
+  if(a.jac) jac = std::move(a.jac);
+  return *this;
+}
+
 /// copy operator
 template<class T> rai::Array<T>& rai::Array<T>::operator=(const std::vector<T>& a) {
   setCarray(&a.front(), a.size());
@@ -1635,6 +1688,19 @@ template<class T> void rai::Array<T>::copyInto2D(T** buffer) const {
   }
 }
 
+/// move the data of a SmallArray from its inline buffer to the heap
+template<class T> void rai::Array<T>::leaveInline() {
+  if(!isInline()) return;
+  uint Mnew = inlineCapacity()+1;
+  T* pnew = (T*)malloc(Mnew*sizeT);
+  if(!pnew) { HALT("memory allocation failed! Wanted size = " <<Mnew*sizeT <<"bytes"); }
+  memmove(pnew, p, sizeT*N);
+  globalMemoryTotal += Mnew*sizeT;
+  if(globalMemoryProfile) memoryProfile_alloc(pnew, Mnew*sizeT, typeid(T).name());
+  p=pnew;
+  M=Mnew;
+}
+
 /// make this array a reference to the array \c a
 template<class T> void rai::Array<T>::referTo(const rai::Array<T>& a) {
   CHECK(!isSpecial(a), "");
@@ -1763,6 +1829,7 @@ template<class T> void rai::Array<T>::takeOver(rai::Array<T>& a) {
   freeMEM();
   memMove=a.memMove;
   N=a.N; nd=a.nd; d0=a.d0; d1=a.d1; d2=a.d2;
+  if(a.isInline()) a.leaveInline(); //a refers to the taken over memory
   p=a.p; M=a.M;
   a.isReference=true;
   a.M=0;
@@ -1777,6 +1844,8 @@ template<class T> void rai::Array<T>::swap(Array<T>& a) {
 #endif
 
 #define SWAPx(X, Y){ auto z=X; X=Y; Y=z; }
+  leaveInline(); //inline buffers stay with their arrays: swap heap memory only
+  a.leaveInline();
   SWAPx(p, a.p);
 //  SWAPx(special, a.special);
 //  SWAPx(isReference, a.isReference);
@@ -2546,9 +2615,7 @@ template<class T>
 T sqrDistance(const rai::Array<T>& v, const rai::Array<T>& w) {
   CHECK_EQ(v.N, w.N,
            "sqrDistance on different array dimensions (" <<v.N <<", " <<w.N <<")");
-  T d, t(0);
-  for(uint i=v.N; i--;) { d=v.p[i]-w.p[i]; t+=d*d; }
-  return t;
+  return rai::simd::sqrDistance(v.p, w.p, v.N);
 }
 
 template<class T> T maxDiff(const rai::Array<T>& v, const rai::Array<T>& w, uint* im) {
@@ -2609,6 +2676,38 @@ T metricDistance(const rai::Array<T>& g, const rai::Array<T>& v, const rai::Arra
   return (T)std::sqrt((double)sqrDistance(g, v, w));
 }
 
+//===========================================================================
+//
+/// @name generic kernels on raw memory (double and float are overloaded in simd.cpp)
+//
+
+namespace rai {
+namespace simd {
+template<class T> T sum(const T* x, uint n) { T t(0); for(uint i=n; i--; t+=x[i]) {}; return t; }
+template<class T> T sumOfSqr(const T* x, uint n) { T t(0); for(uint i=n; i--; t+=x[i]*x[i]) {}; return t; }
+template<class T> T sumOfAbs(const T* x, uint n) { T t(0); for(uint i=n; i--; t+=(T)std::fabs((double)x[i])) {}; return t; }
+template<class T> T sumOfPos(const T* x, uint n) { T t(0); for(uint i=0; i<n; i++) if(x[i]>0) t+=x[i]; return t; }
+template<class T> T absMax(const T* x, uint n) {
+  if(!n) return (T)0;
+  T t((T)std::fabs((double)x[0]));
+  for(uint i=1; i<n; i++) if(std::fabs((double)x[i])>t) t=(T)std::fabs((double)x[i]);
+  return t;
+}
+template<class T> T scalarProduct(const T* x, const T* y, uint n) { T t(0); for(uint i=n; i--; t+=x[i]*y[i]) {}; return t; }
+template<class T> T sqrDistance(const T* x, const T* y, uint n) { T d, t(0); for(uint i=n; i--;) { d=x[i]-y[i]; t+=d*d; } return t; }
+template<class T> void add(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] += y[i]; }
+template<class T> void sub(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] -= y[i]; }
+template<class T> void mul(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] *= y[i]; }
+template<class T> void div(T* x, const T* y, uint n) { for(uint i=0; i<n; i++) x[i] /= y[i]; }
+template<class T> void add(T* x, T y, uint n) { for(uint i=0; i<n; i++) x[i] += y; }
+template<class T> void sub(T* x, T y, uint n) { for(uint i=0; i<n; i++) x[i] -= y; }
+template<class T> void mul(T* x, T y, uint n) { for(uint i=0; i<n; i++) x[i] *= y; }
+template<class T> void div(T* x, T y, uint n) { for(uint i=0; i<n; i++) x[i] /= y; }
+template<class T> void min(T* z, const T* x, const T* y, uint n) { for(uint i=0; i<n; i++) z[i] = x[i]<y[i]?x[i]:y[i]; }
+template<class T> void max(T* z, const T* x, const T* y, uint n) { for(uint i=0; i<n; i++) z[i] = x[i]>y[i]?x[i]:y[i]; }
+}
+}
+
 //===========================================================================
 //
 /// @name running sums
@@ -2616,9 +2715,7 @@ T metricDistance(const rai::Array<T>& g, const rai::Array<T>& v, const rai::Arra
 
 /// \f$\sum_i x_i\f$
 template<class T> T sum(const rai::Array<T>& v) {
-  T t(0);
-  for(uint i=v.N; i--; t+=v.p[i]) {};
-  return t;
+  return rai::simd::sum(v.p, v.N);
 }
 
 /// \f$\max_i x_i\f$
@@ -2733,23 +2830,17 @@ template<class T> rai::Array<T> min(const rai::Array<T>& v, uint d) {
 
 /// \f$\sum_i |x_i|\f$
 template<class T> T sumOfAbs(const rai::Array<T>& v) {
-  T t(0);
-  for(uint i=v.N; i--; t+=(T)std::fabs((double)v.p[i])) {};
-  return t;
+  return rai::simd::sumOfAbs(v.p, v.N);
 }
 
 /// \f$\sum_i |x_i|_+\f$
 template<class T> T sumOfPos(const rai::Array<T>& v) {
-  T t(0);
-  for(uint i=0;i<v.N;i++) if(v.p[i]>0) t+=v.p[i];
-  return t;
+  return rai::simd::sumOfPos(v.p, v.N);
 }
 
 /// \f$\sum_i x_i^2\f$
 template<class T> T sumOfSqr(const rai::Array<T>& v) {
-  T t(0);
-  for(uint i=v.N; i--; t+=v.p[i]*v.p[i]) {};
-  return t;
+  return rai::simd::sumOfSqr(v.p, v.N);
 }
 
 /// \f$\sqrt{\sum_i x_i^2}\f$
@@ -2803,11 +2894,7 @@ template<class T> T absMin(const rai::Array<T>& x) {
 
 /// get absolute maximum (using fabs)
 template<class T> T absMax(const rai::Array<T>& x) {
-  if(!x.N) return (T)0;
-  uint i;
-  T t((T)std::fabs((double)x.p[0]));
-  for(i=1; i<x.N; i++) if(std::fabs((double)x.p[i])>t) t=(T)std::fabs((double)x.p[i]);
-  return t;
+  return rai::simd::absMax(x.p, x.N);
 }
 
 /// get absolute min (using fabs)
@@ -2893,7 +2980,7 @@ void op_innerProduct(rai::Array<T>& x, const rai::Array<T>& y, const rai::Array<
       if(isSparseMatrix(z)) { x = z.sparse().B_A(y); return; }
       if(isRowShifted(y)) { x = y.rowShifted().A_B(z); return; }
       if(isRowShifted(z)) { x = z.rowShifted().B_A(y); return; }
-      if(rai::useLapack){ blas_MM(x, y, z); return; }
+      if(rai::useLapack && !y.jac && !z.jac){ blas_MM(x, y, z); return; }
     }
     T* a, *astop, *b, *c;
     x.resize(d0, d1); x.setZero();
@@ -3152,7 +3239,7 @@ T scalarProduct(const rai::Array<T>& v, const rai::Array<T>& w) {
   if(!v.special && !w.special) {
     CHECK_EQ(v.N, w.N,
              "scalar product on different array dimensions (" <<v.N <<", " <<w.N <<")");
-    for(uint i=v.N; i--; t+=v.p[i]*w.p[i]);
+    t = rai::simd::scalarProduct(v.p, w.p, v.N);
   } else {
     if(isSparseVector(v) && isSparseVector(w)) {
       rai::SparseVector* sv = dynamic_cast<rai::SparseVector*>(v.special);
@@ -3195,16 +3282,18 @@ T scalarProduct(const rai::Array<T>& g, const rai::Array<T>& v, const rai::Array
 }
 
 template<class T> rai::Array<T> elemWiseMin(const rai::Array<T>& v, const rai::Array<T>& w) {
+  CHECK_EQ(v.N, w.N, "");
   rai::Array<T> z;
   z.resizeAs(v);
-  for(uint i=0; i<v.N; i++) z.elem(i) = v.elem(i)<w.elem(i)?v.elem(i):w.elem(i);
+  rai::simd::min(z.p, v.p, w.p, v.N);
   return z;
 }
 
 template<class T> rai::Array<T> elemWiseMax(const rai::Array<T>& v, const rai::Array<T>& w) {
+  CHECK_EQ(v.N, w.N, "");
   rai::Array<T> z;
   z.resizeAs(v);
-  for(uint i=0; i<v.N; i++) z.elem(i) = v.elem(i)>w.elem(i)?v.elem(i):w.elem(i);
+  rai::simd::max(z.p, v.p, w.p, v.N);
   return z;
 }
 
@@ -3875,6 +3964,20 @@ template<class T> Array<T> operator-(const Array<T>& y, const Array<T>& z) { Arr
 template<class T> Array<T> operator-(T y, const Array<T>& z){                Array<T> x; x.resizeAs(z); x=y; x-=z; return x; }
 template<class T> Array<T> operator-(const Array<T>& y, T z){                Array<T> x(y); x-=z; return x; }
 
+//operators on temporaries: reuse their memory (but never write into references)
+template<class T> Array<T> operator+(Array<T>&& y, const Array<T>& z) { if(y.isReference) return (const Array<T>&)y + z;  y+=z; return std::move(y); }
+template<class T> Array<T> operator+(const Array<T>& y, Array<T>&& z) { if(z.isReference || !samedim(y, z)) return y + (const Array<T>&)z;  z+=y; return std::move(z); }
+template<class T> Array<T> operator+(Array<T>&& y, Array<T>&& z) { return std::move(y) + (const Array<T>&)z; }
+template<class T> Array<T> operator+(Array<T>&& y, T z) { if(y.isReference) return (const Array<T>&)y + z;  y+=z; return std::move(y); }
+template<class T> Array<T> operator+(T y, Array<T>&& z) { if(z.isReference) return y + (const Array<T>&)z;  z+=y; return std::move(z); }
+template<class T> Array<T> operator-(Array<T>&& y, const Array<T>& z) { if(y.isReference) return (const Array<T>&)y - z;  y-=z; return std::move(y); }
+template<class T> Array<T> operator-(Array<T>&& y, T z) { if(y.isReference) return (const Array<T>&)y - z;  y-=z; return std::move(y); }
+template<class T> Array<T> operator-(Array<T>&& y) { if(y.isReference || y.special) return -(const Array<T>&)y;  y*=(T)-1; return std::move(y); }
+template<class T> Array<T> operator*(Array<T>&& y, T z) { if(y.isReference) return (const Array<T>&)y * z;  y*=z; return std::move(y); }
+template<class T> Array<T> operator*(T y, Array<T>&& z) { if(z.isReference) return y * (const Array<T>&)z;  z*=y; return std::move(z); }
+template<class T> Array<T> operator/(Array<T>&& y, T z) { if(y.isReference) return (const Array<T>&)y / z;  y/=z; return std::move(y); }
+template<class T> Array<T> operator/(Array<T>&& y, const Array<T>& z) { if(y.isReference) return (const Array<T>&)y / z;  y/=z; return std::move(y); }
+
 /// transpose
 template<class T> Array<T> operator~(const Array<T>& y) { Array<T> x; op_transpose(x, y); return x; }
 /// negative
@@ -3911,29 +4014,26 @@ template<class T> Array<T>& operator<<(Array<T>& x, const Array<T>& y) { x.appen
 
 
 //core for matrix-matrix (elem-wise) update
-#define UpdateOperator_MM( op )        \
+#define UpdateOperator_MM( op, kernel )        \
     if(isNoArr(x)){ return x; } \
     if(isSparseMatrix(x) && isSparseMatrix(y)){ x.sparse() op y.sparse(); return x; }  \
     if(isRowShifted(x) && isRowShifted(y)){ x.rowShifted() op y.rowShifted(); return x; }  \
     CHECK(!isSpecial(x), "");  \
     CHECK(!isSpecial(y), "");  \
     CHECK_EQ(x.N, y.N, "update operator on different array dimensions (" <<x.N <<", " <<y.N <<")"); \
-    T *xp=x.p, *xstop=xp+x.N;              \
-    const T *yp=y.p;              \
-    for(; xp!=xstop; xp++, yp++) *xp op *yp;
+    rai::simd::kernel(x.p, y.p, x.N);
 
 //core for matrix-scalar update
-#define UpdateOperator_MS( op ) \
+#define UpdateOperator_MS( op, kernel ) \
   if(isNoArr(x)){ return x; } \
   if(isSparseMatrix(x)){ x.sparse() op y; return x; }  \
   if(isRowShifted(x)){ x.rowShifted() op y; return x; }  \
   CHECK(!isSpecial(x), "");  \
-  T *xp=x.p, *xstop=xp+x.N;              \
-  for(; xp!=xstop; xp++) *xp op y;
+  rai::simd::kernel(x.p, y, x.N);
 
 
 template<class T> Array<T>& operator+=(Array<T>& x, const Array<T>& y){
-  UpdateOperator_MM(+=);
+  UpdateOperator_MM(+=, add);
   if(y.jac){
     if(x.jac) *x.jac += *y.jac;
     else x.J() = *y.jac;
@@ -3941,11 +4041,11 @@ template<class T> Array<T>& operator+=(Array<T>& x, const Array<T>& y){
   return x;
 }
 template<class T> Array<T>& operator+=(Array<T>& x, T y){
-  UpdateOperator_MS(+=);
+  UpdateOperator_MS(+=, add);
   return x;
 }
   template<class T> Array<T>& operator+=(Array<T>&& x, const Array<T>& y){
-    UpdateOperator_MM(+=);
+    UpdateOperator_MM(+=, add);
     if(y.jac){
       if(x.jac) *x.jac += *y.jac;
       else x.J() = *y.jac;
@@ -3953,12 +4053,12 @@ template<class T> Array<T>& operator+=(Array<T>& x, T y){
     return x;
   }
   template<class T> Array<T>& operator+=(Array<T>&& x, T y){
-    UpdateOperator_MS(+=);
+    UpdateOperator_MS(+=, add);
     return x;
   }
 
 template<class T> Array<T>& operator-=(Array<T>& x, const Array<T>& y){
-  UpdateOperator_MM(-=);
+  UpdateOperator_MM(-=, sub);
   if(y.jac){
     if(x.jac) *x.jac -= *y.jac;
     else x.J() = -(*y.jac);
@@ -3966,11 +4066,11 @@ template<class T> Array<T>& operator-=(Array<T>& x, const Array<T>& y){
   return x;
 }
 template<class T> Array<T>& operator-=(Array<T>& x, T y){
-  UpdateOperator_MS(-=);
+  UpdateOperator_MS(-=, sub);
   return x;
 }
   template<class T> Array<T>& operator-=(Array<T>&& x, const Array<T>& y){
-    UpdateOperator_MM(-=);
+    UpdateOperator_MM(-=, sub);
     if(y.jac){
       if(x.jac) *x.jac -= *y.jac;
       else x.J() = -(*y.jac);
@@ -3978,7 +4078,7 @@ template<class T> Array<T>& operator-=(Array<T>& x, T y){
     return x;
   }
   template<class T> Array<T>& operator-=(Array<T>&& x, T y){
-    UpdateOperator_MS(-=);
+    UpdateOperator_MS(-=, sub);
     return x;
   }
 
@@ -3990,12 +4090,12 @@ template<class T> Array<T>& operator*=(Array<T>& x, const Array<T>& y){
     else if(!x.jac && y.jac) x.J() = x % (*y.jac);
     else NIY;
   }
-  UpdateOperator_MM(*=);
+  UpdateOperator_MM(*=, mul);
   return x;
 }
 template<class T> Array<T>& operator*=(Array<T>& x, T y){
   if(x.jac) *x.jac *= y;
-  UpdateOperator_MS(*=);
+  UpdateOperator_MS(*=, mul);
   return x;
 }
   template<class T> Array<T>& operator*=(Array<T>&& x, const Array<T>& y){
@@ -4005,36 +4105,36 @@ template<class T> Array<T>& operator*=(Array<T>& x, T y){
       else if(!x.jac && y.jac) x.J() = x.noJ() % (*y.jac);
       else NIY;
     }
-    UpdateOperator_MM(*=);
+    UpdateOperator_MM(*=, mul);
     return x;
   }
   template<class T> Array<T>& operator*=(Array<T>&& x, T y){
     if(x.jac) *x.jac *= y;
-    UpdateOperator_MS(*=);
+    UpdateOperator_MS(*=, mul);
     return x;
   }
 
 template<class T> Array<T>& operator/=(Array<T>& x, const Array<T>& y){
-  UpdateOperator_MM(/=);
+  UpdateOperator_MM(/=, div);
   if(x.jac || y.jac){
     NIY;
   }
   return x;
 }
 template<class T> Array<T>& operator/=(Array<T>& x, T y){
-  UpdateOperator_MS(/=);
+  UpdateOperator_MS(/=, div);
   if(x.jac) *x.jac /= y;
   return x;
 }
   template<class T> Array<T>& operator/=(Array<T>&& x, const Array<T>& y){
-    UpdateOperator_MM(/=);
+    UpdateOperator_MM(/=, div);
     if(x.jac || y.jac){
       NIY;
     }
     return x;
   }
   template<class T> Array<T>& operator/=(Array<T>&& x, T y){
-    UpdateOperator_MS(/=);
+    UpdateOperator_MS(/=, div);
     if(x.jac) *x.jac /= y;
     return x;
   }
@@ -4729,6 +4829,46 @@ void maximumSpanningTree(rai::Array<vert*>& V, rai::Array<edge*>& E, const Compa
   graphMakeLists(V, E);
 }
 
+//===========================================================================
+//
+// memory-mapped binary array files
+//
+
+template<class T> std::string rai::arrayDtype() {
+  if(std::is_same<T, bool>::value) return "b1";
+  char kind=0;
+  if(std::is_floating_point<T>::value) kind='f';
+  else if(std::is_integral<T>::value) kind = std::is_signed<T>::value ? 'i' : 'u';
+  if(!kind) return std::string(typeid(T).name()).substr(0, 15);
+  return std::string(1, kind) + std::to_string(sizeof(T));
+}
+
+template<class T> void rai::writeArrayFile(const Array<T>& x, const char* filename, uint alignment) {
+  CHECK(Array<T>::memMove, "binary array files are only for POD types");
+  CHECK(!isSpecial(x), "binary array files only store dense arrays");
+  CHECK_LE(x.nd, 8, "");
+  ArrayFileHeader head;
+  memset(&head, 0, sizeof(head));
+  strncpy(head.dtype, arrayDtype<T>().c_str(), sizeof(head.dtype)-1);
+  head.elemSize = sizeof(T);
+  head.nd = x.nd;
+  for(uint i=0; i<x.nd; i++) head.dim[i] = x.dim(i);
+  head.alignment = alignment;
+  head.dataBytes = uint64_t(x.N)*sizeof(T);
+  writeArrayFile(filename, head, x.p);
+}
+
+template<class T> std::shared_ptr<rai::MappedFile> rai::mapArrayFile(Array<T>& x, const char* filename, bool verifyChecksum, bool copyOnWrite) {
+  CHECK(Array<T>::memMove, "binary array files are only for POD types");
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename, copyOnWrite);
+  const ArrayFileHeader& head = checkArrayFile(*file, filename, arrayDtype<T>().c_str(), sizeof(T), verifyChecksum);
+  x.referTo((const T*)(file->p+head.dataOffset), head.dataBytes/sizeof(T));
+  uintA dims(head.nd);
+  for(uint i=0; i<head.nd; i++) dims(i) = head.dim[i];
+  x.reshape(dims);
+  return file;
+}
+
 //namespace rai{
 //template<class T> Array<T>::Array(std::initializer_list<const char*> list) {
 //  init();
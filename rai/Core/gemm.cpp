@@ -0,0 +1,206 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#include "array.h"
+#include "thread.h"
+
+//===========================================================================
+//
+// built-in dense kernels, used by the blas_* wrappers when no BLAS is linked
+//
+// GEMM follows the usual packed scheme: a KC x NC panel of B and an MC x KC block of A are packed into contiguous
+// slivers, and a micro-kernel accumulates an MR x NR tile of C in registers (the fixed-size inner loop is
+// vectorized by the compiler). Large products are split over row blocks on the thread pool; every tile of C is
+// computed by exactly one task in a fixed order, so results do not depend on the number of threads.
+//
+
+namespace {
+
+#ifdef __AVX__
+const uint MR=4, NR=8;
+#else
+const uint MR=4, NR=4;
+#endif
+const uint MC=96, KC=256, NC=2048;
+const double parallelWork=1e7; //multiply-adds above which products are split over the thread pool
+
+/// strided read-only view: element (i,j) is p[i*rs+j*cs] (transposes are views, never copies)
+struct MatView {
+  const double* p;
+  uint rs, cs;
+};
+
+bool useThreads(double work) {
+  if(work<parallelWork || rai::threadPool().isWorker()) return false; //no nested parallelism within pool tasks
+  return rai::threadPool().nThreads()>1;
+}
+
+/// packs the kc x nc block of B at (pc,jc) into NR-wide slivers stored row by row (zero padded)
+void packB(double* Bp, const MatView& B, uint pc, uint jc, uint kc, uint nc) {
+  for(uint j=0; j<nc; j+=NR) {
+    uint nr = rai::MIN(NR, nc-j);
+    for(uint p=0; p<kc; p++) {
+      const double* b = B.p + (pc+p)*B.rs + (jc+j)*B.cs;
+      uint jj=0;
+      for(; jj<nr; jj++) Bp[jj] = b[jj*B.cs];
+      for(; jj<NR; jj++) Bp[jj] = 0.;
+      Bp += NR;
+    }
+  }
+}
+
+/// packs the mc x kc block of A at (ic,pc) into MR-high slivers stored column by column (zero padded)
+void packA(double* Ap, const MatView& A, uint ic, uint pc, uint mc, uint kc) {
+  for(uint i=0; i<mc; i+=MR) {
+    uint mr = rai::MIN(MR, mc-i);
+    for(uint p=0; p<kc; p++) {
+      const double* a = A.p + (ic+i)*A.rs + (pc+p)*A.cs;
+      uint ii=0;
+      for(; ii<mr; ii++) Ap[ii] = a[ii*A.rs];
+      for(; ii<MR; ii++) Ap[ii] = 0.;
+      Ap += MR;
+    }
+  }
+}
+
+/// C(0:mr,0:nr) = (or +=) the product of an A sliver and a B sliver over kc
+inline void microKernel(uint kc, const double* __restrict Ap, const double* __restrict Bp,
+                        double* __restrict C, uint ldc, uint mr, uint nr, bool accumulate) {
+  double c[MR][NR];
+  for(uint i=0; i<MR; i++) for(uint j=0; j<NR; j++) c[i][j] = 0.;
+  for(uint p=0; p<kc; p++) {
+    for(uint i=0; i<MR; i++) {
+      double a = Ap[i];
+      for(uint j=0; j<NR; j++) c[i][j] += a*Bp[j];
+    }
+    Ap += MR;
+    Bp += NR;
+  }
+  if(accumulate) {
+    for(uint i=0; i<mr; i++) for(uint j=0; j<nr; j++) C[i*ldc+j] += c[i][j];
+  } else {
+    for(uint i=0; i<mr; i++) for(uint j=0; j<nr; j++) C[i*ldc+j] = c[i][j];
+  }
+}
+
+/// C (m x n, row-major, overwritten) = A B with A m x k and B k x n; with upper=true only tiles touching the upper triangle are computed
+void gemm(double* C, uint m, uint n, uint k, const MatView& A, const MatView& B, bool upper) {
+  if(!m || !n) return;
+  if(!k) { memset(C, 0, m*n*sizeof(double)); return; }
+  std::vector<double> Bp;
+  uint nBlocks = (m+MC-1)/MC;
+  bool threads = useThreads(double(m)*n*k);
+  for(uint jc=0; jc<n; jc+=NC) {
+    uint nc = rai::MIN(NC, n-jc);
+    for(uint pc=0; pc<k; pc+=KC) {
+      uint kc = rai::MIN(KC, k-pc);
+      Bp.resize(kc*((nc+NR-1)/NR)*NR);
+      packB(Bp.data(), B, pc, jc, kc, nc);
+      auto block = [&](uint b) {
+        uint ic=b*MC, mc=rai::MIN(MC, m-ic);
+        if(upper && jc+nc<=ic) return;
+        thread_local std::vector<double> Ap;
+        Ap.resize(MC*KC);
+        packA(Ap.data(), A, ic, pc, mc, kc);
+        for(uint jr=0; jr<nc; jr+=NR) for(uint ir=0; ir<mc; ir+=MR) {
+            if(upper && jc+jr+NR<=ic+ir) continue;
+            microKernel(kc, Ap.data()+ir*kc, Bp.data()+jr*kc, C+(ic+ir)*n+jc+jr, n,
+                        rai::MIN(MR, mc-ir), rai::MIN(NR, nc-jr), pc>0);
+          }
+      };
+      if(threads) rai::parallel_for(0, nBlocks, block, 1);
+      else for(uint b=0; b<nBlocks; b++) block(b);
+    }
+  }
+}
+
+void mirrorUpper(arr& X) {
+  uint n=X.d0;
+  for(uint i=0; i<n; i++) for(uint j=0; j<i; j++) X.p[i*n+j] = X.p[j*n+i];
+}
+
+/// small products: plain i-k-j loops (vectorizable, no packing overhead)
+void smallMM(double* C, uint m, uint n, uint k, const double* A, const double* B) {
+  memset(C, 0, m*n*sizeof(double));
+  for(uint i=0; i<m; i++) {
+    double* c = C+i*n;
+    for(uint p=0; p<k; p++) {
+      double a = A[i*k+p];
+      const double* b = B+p*n;
+      for(uint j=0; j<n; j++) c[j] += a*b[j];
+    }
+  }
+}
+
+}//namespace
+
+//===========================================================================
+
+void native_MM(arr& X, const arr& A, const arr& B) {
+  CHECK(A.nd==2 && B.nd==2, "");
+  CHECK_EQ(A.d1, B.d0, "matrix multiplication: wrong dimensions");
+  uint m=A.d0, n=B.d1, k=A.d1;
+  X.resize(m, n);
+  if(uint64_t(m)*n*k<=MC*MR*NR) { smallMM(X.p, m, n, k, A.p, B.p); return; }
+  gemm(X.p, m, n, k, {A.p, A.d1, 1}, {B.p, B.d1, 1}, false);
+}
+
+void native_At_A(arr& X, const arr& A) {
+  CHECK_EQ(A.nd, 2, "");
+  uint n=A.d1;
+  X.resize(n, n);
+  gemm(X.p, n, n, A.d0, {A.p, 1, A.d1}, {A.p, A.d1, 1}, true);
+  mirrorUpper(X);
+}
+
+void native_A_At(arr& X, const arr& A) {
+  CHECK_EQ(A.nd, 2, "");
+  uint n=A.d0;
+  X.resize(n, n);
+  gemm(X.p, n, n, A.d1, {A.p, A.d1, 1}, {A.p, 1, A.d1}, true);
+  mirrorUpper(X);
+}
+
+void native_Mv(arr& y, const arr& A, const arr& x) {
+  CHECK_EQ(A.nd, 2, "");
+  CHECK_EQ(A.d1, x.N, "matrix multiplication: wrong dimensions");
+  uint m=A.d0, k=A.d1;
+  y.resize(m);
+  const double* xp=x.p;
+  auto rows = [&](uint lo, uint up) {
+    for(uint i=lo; i<up; i++) {
+      const double* a = A.p+i*k;
+      double s0=0., s1=0., s2=0., s3=0.;
+      uint j=0;
+      for(; j+4<=k; j+=4) { s0+=a[j]*xp[j]; s1+=a[j+1]*xp[j+1]; s2+=a[j+2]*xp[j+2]; s3+=a[j+3]*xp[j+3]; }
+      for(; j<k; j++) s0+=a[j]*xp[j];
+      y.p[i] = (s0+s1)+(s2+s3);
+    }
+  };
+  if(!useThreads(double(m)*k)) { rows(0, m); return; }
+  uint chunk=64;
+  rai::parallel_for(0, (m+chunk-1)/chunk, [&](uint c) { rows(c*chunk, rai::MIN(m, (c+1)*chunk)); }, 1);
+}
+
+void native_At_x(arr& y, const arr& A, const arr& x) {
+  CHECK_EQ(A.nd, 2, "");
+  CHECK_EQ(A.d0, x.N, "matrix multiplication: wrong dimensions");
+  uint m=A.d0, n=A.d1;
+  y.resize(n).setZero();
+  auto cols = [&](uint lo, uint up) { //streams through the rows of A, restricted to columns [lo,up)
+    for(uint i=0; i<m; i++) {
+      double xi=x.p[i];
+      if(!xi) continue;
+      const double* a = A.p+i*n;
+      for(uint j=lo; j<up; j++) y.p[j] += xi*a[j];
+    }
+  };
+  if(!useThreads(double(m)*n)) { cols(0, n); return; }
+  uint chunk=256;
+  rai::parallel_for(0, (n+chunk-1)/chunk, [&](uint c) { cols(c*chunk, rai::MIN(n, (c+1)*chunk)); }, 1);
+}
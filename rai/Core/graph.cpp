@@ -11,6 +11,8 @@
 #include "array.ipp"
 
 #include <map>
+#include <unordered_map>
+#include <atomic>
 
 #ifdef RAI_JSON
 #  include <jsoncpp/json/json.h>
@@ -49,7 +51,7 @@ stdOutPipe(ParseInfo)
 
 //-- query existing types
 inline Node* reg_findType(const char* key) {
-  NodeL types = getParameters()->getNodesOfType<std::shared_ptr<Type>>();
+  NodeL types = readParameters()->getNodesOfType<std::shared_ptr<Type>>();
   for(Node* ti: types) {
     if(String(ti->get<std::shared_ptr<Type>>()->typeId().name())==key) return ti;
     if(ti->matches(key)) return ti;
@@ -68,20 +70,76 @@ inline Node* readTypeIntoNode(Graph& container, const char* key, std::istream& i
   return nullptr;
 }
 
+//===========================================================================
+//
+//  key index: nodes by hash of their key, each bucket in the order of the graph
+//
+
+struct KeyIndex {
+  std::unordered_map<uint64_t, std::vector<Node*>> buckets;
+
+  static uint64_t hash(const char* key) {
+    uint64_t h = checksum_fnv1a(key, strlen(key));
+    return h ? h : 1;
+  }
+
+  const std::vector<Node*>* find(const char* key) const {
+    auto it = buckets.find(hash(key));
+    if(it==buckets.end()) return nullptr;
+    return &it->second;
+  }
+
+  void add(Node* n, bool isLast) {
+    if(!n->key.N) return;
+    n->keyHash = hash(n->key.p);
+    std::vector<Node*>& B = buckets[n->keyHash];
+    if(isLast || !B.size()) { B.push_back(n); return; }
+    if(!n->container.isIndexed) n->container.index();
+    uint i=0;
+    while(i<B.size() && B[i]->index<n->index) i++;
+    B.insert(B.begin()+i, n);
+  }
+
+  void remove(Node* n) {
+    if(!n->keyHash) return;
+    auto it = buckets.find(n->keyHash);
+    n->keyHash = 0;
+    if(it==buckets.end()) return;
+    std::vector<Node*>& B = it->second;
+    for(uint i=B.size(); i--;) if(B[i]==n) { B.erase(B.begin()+i); break; }
+    if(!B.size()) buckets.erase(it);
+  }
+};
+
+uint Graph::keyIndexMinN=16;
+
+/// calls f(n) for all nodes that might match the key (all nodes, if there is no index) until f returns true
+template<class F> void forKeyCandidates(const Graph& G, const char* key, const F& f) {
+  if(G.keyIndex && key && *key) {
+    const std::vector<Node*>* B = G.keyIndex->find(key);
+    if(B) for(Node* n:*B) if(f(n)) return;
+  } else {
+    for(Node* n:G) if(f(n)) return;
+  }
+}
+
 //===========================================================================
 //
 //  Node methods
 //
 
 Node::Node(const std::type_info& _type, Graph& _container, const char* _key, const NodeL& _parents)
-  : type(_type), container(_container), key(_key) {
+  : type(_type), container(_container), keyString(_key), key(keyString) {
   CHECK(&container!=&NoGraph, "This is a NGraph (nullptr) -- don't do that anymore!");
   index=container.N;
   container.NodeL::append(this);
+  if(container.keyIndex) container.keyIndex->add(this, true);
+  else if(container.useKeyIndex && container.N>=Graph::keyIndexMinN) container.rebuildKeyIndex();
   if(_parents.N) for(Node* p: _parents) addParent(p);
 }
 
 Node::~Node() {
+  if(container.keyIndex) container.keyIndex->remove(this);
   if(container.isDoubleLinked) while(children.N) children.last()->removeParent(this);
   if(numChildren) LOG(-2) <<"It is not allowed to delete nodes that still have children";
   while(parents.N) removeParent(parents.last());
@@ -119,6 +177,12 @@ void Node::swapParent(uint i, Node* p) {
   if(container.isDoubleLinked) parents(i)->children.append(this);
 }
 
+void Node::setKey(const char* _key) {
+  if(container.keyIndex) container.keyIndex->remove(this);
+  keyString = _key;
+  if(container.keyIndex) container.keyIndex->add(this, false);
+}
+
 bool Node::matches(const char* _key) {
   if(key==_key) return true;
   return false;
@@ -242,7 +306,7 @@ NodeInitializer::NodeInitializer(const char* key, const char* stringValue) {
 //  Graph methods
 //
 
-Graph::Graph() : isNodeOfGraph(nullptr), pi(nullptr), ri(nullptr) {
+Graph::Graph() : isNodeOfGraph(nullptr), pi(nullptr), ri(nullptr), keyIndex(nullptr) {
 }
 
 Graph::Graph(const char* filename, bool parseInfo): Graph() {
@@ -277,6 +341,7 @@ Graph::Graph(const Graph& G) : Graph() {
 
 Graph::~Graph() {
   clear();
+  if(keyIndex) { delete keyIndex; keyIndex=nullptr; }
 }
 
 bool Graph::operator!() const {
@@ -286,6 +351,10 @@ bool Graph::operator!() const {
 void Graph::clear() {
   if(ri) { delete ri; ri=nullptr; }
   if(pi) { delete pi; pi=nullptr; }
+  if(keyIndex) { //all nodes go: drop the index in batch
+    for(Node* n:*this) n->keyHash=0;
+    keyIndex->buckets.clear();
+  }
   DEBUG(checkConsistency();)
   if(!isNodeOfGraph) { //this is not a subgraph; save to delete connections in batch -> faster
     NodeL all = getAllNodesRecursively();
@@ -293,7 +362,7 @@ void Graph::clear() {
       n->parents.clear();
       n->numChildren=0;
       n->children.clear();
-      n->key.clear();
+      n->setKey("");
     }
     DEBUG(checkConsistency();)
   }
@@ -339,9 +408,27 @@ void Graph::appendDict(const std::map<std::string, std::string>& dict) {
   }
 }
 
+void Graph::setKeyIndex(bool enable) {
+  useKeyIndex=enable;
+  if(enable) {
+    if(N>=keyIndexMinN) rebuildKeyIndex();
+  } else if(keyIndex) {
+    for(Node* n:*this) n->keyHash=0;
+    delete keyIndex;
+    keyIndex=nullptr;
+  }
+}
+
+void Graph::rebuildKeyIndex() {
+  if(!keyIndex) keyIndex = new KeyIndex;
+  keyIndex->buckets.clear();
+  for(Node* n:*this) keyIndex->add(n, true);
+}
+
 Node* Graph::findNode(const char* key, bool recurseUp, bool recurseDown) const {
-  for(Node* n: (*this)) if(n->matches(key)) return n;
   Node* ret=nullptr;
+  forKeyCandidates(*this, key, [&](Node* n) { if(n->matches(key)) ret=n; return ret!=nullptr; });
+  if(ret) return ret;
   if(recurseUp && isNodeOfGraph) ret = isNodeOfGraph->container.findNode(key, true, false);
   if(ret) return ret;
   if(recurseDown) for(Node* n: (*this)) if(n->isGraph()) {
@@ -352,8 +439,9 @@ Node* Graph::findNode(const char* key, bool recurseUp, bool recurseDown) const {
 }
 
 Node* Graph::findNodeOfType(const std::type_info& type, const char* key, bool recurseUp, bool recurseDown) const {
-  for(Node* n: (*this)) if(n->type==type && (!key || n->matches(key))) return n;
   Node* ret=nullptr;
+  forKeyCandidates(*this, key, [&](Node* n) { if(n->type==type && (!key || n->matches(key))) ret=n; return ret!=nullptr; });
+  if(ret) return ret;
   if(recurseUp && isNodeOfGraph) ret = isNodeOfGraph->container.findNodeOfType(type, key, true, false);
   if(ret) return ret;
   if(recurseDown) for(Node* n: (*this)) if(n->isGraph()) {
@@ -365,7 +453,7 @@ Node* Graph::findNodeOfType(const std::type_info& type, const char* key, bool re
 
 NodeL Graph::findNodes(const char* key, bool recurseUp, bool recurseDown) const {
   NodeL ret;
-  for(Node* n: (*this)) if(n->matches(key)) ret.append(n);
+  forKeyCandidates(*this, key, [&](Node* n) { if(n->matches(key)) ret.append(n); return false; });
   if(recurseUp && isNodeOfGraph) ret.append(isNodeOfGraph->container.findNodes(key, true, false));
   if(recurseDown) for(Node* n: (*this)) if(n->isGraph()) ret.append(n->graph().findNodes(key, false, true));
   return ret;
@@ -373,7 +461,7 @@ NodeL Graph::findNodes(const char* key, bool recurseUp, bool recurseDown) const
 
 NodeL Graph::findNodesOfType(const std::type_info& type, const char* key, bool recurseUp, bool recurseDown) const {
   NodeL ret;
-  for(Node* n: (*this)) if(n->type==type && (!key || n->matches(key))) ret.append(n);
+  forKeyCandidates(*this, key, [&](Node* n) { if(n->type==type && (!key || n->matches(key))) ret.append(n); return false; });
   if(recurseUp && isNodeOfGraph) ret.append(isNodeOfGraph->container.findNodesOfType(type, key, true, false));
   if(recurseDown) for(Node* n: (*this)) if(n->isGraph()) ret.append(n->graph().findNodesOfType(type, key, false, true));
   return ret;
@@ -614,7 +702,7 @@ void Graph::read(std::istream& is, bool parseInfo) {
       uint Nbefore = N;
       read(n->get<FileToken>().getIs(true), parseInfo);
       if(namePrefix.N) { //prepend a naming prefix to all nodes just read
-        for(uint i=Nbefore; i<N; i++) elem(i)->key.prepend(namePrefix);
+        for(uint i=Nbefore; i<N; i++) elem(i)->setKey(STRING(namePrefix <<elem(i)->key));
         namePrefix.clear();
       }
       n->get<FileToken>().cd_start();
@@ -1136,6 +1224,7 @@ void Graph::sortByDotOrder() {
   permuteInv(perm);
   it_COUNT=0;
   for(Node *it: list()) it->index=it_COUNT++;
+  if(keyIndex) rebuildKeyIndex();
 }
 
 ParseInfo& Graph::getParseInfo(Node* n) {
@@ -1190,6 +1279,22 @@ bool Graph::isChildOfGraph(const Graph& G) const {
 bool Graph::checkConsistency() const {
   uint idx=0;
 
+  if(keyIndex) {
+    uint n=0;
+    for(auto& B:keyIndex->buckets) for(uint i=0; i<B.second.size(); i++) {
+        Node* node=B.second[i];
+        CHECK_EQ(&node->container, this, "");
+        CHECK_EQ(node->keyHash, B.first, "");
+        if(i && isIndexed) CHECK_LE(B.second[i-1]->index, node->index, "key index bucket out of order");
+        n++;
+      }
+    for(Node* node: *this) if(node->key.N) {
+        CHECK_EQ(node->keyHash, KeyIndex::hash(node->key.p), "key of '" <<node->key <<"' changed without setKey");
+        n--;
+      }
+    CHECK_EQ(n, 0, "key index has stale nodes");
+  }
+
 #if 0 //this is expensive: fill all the parentsOf lists
   NodeL ALL = getAllNodesRecursively();
   if(!isDoubleListed) {
@@ -1319,17 +1424,32 @@ int distance(NodeL A, NodeL B) {
 //
 
 Singleton<Graph> parameterGraph;
+std::atomic<uint64_t> parameterRevision(1);
+
+ParametersToken::~ParametersToken() {
+  //bumped after the modifications but before unlocking: a cache fill (which reads the revision under the lock)
+  //either sees the old graph with the old revision or the new graph with the new one
+  if(owns_lock()) parameterRevision++;
+}
+
+ParametersToken getParameters(){
+  return ParametersToken(parameterGraph());
+}
 
-Mutex::TypedToken<Graph> getParameters(){
+Mutex::TypedToken<Graph> readParameters(){
   return parameterGraph();
 }
 
+uint64_t getParametersRevision(){
+  return parameterRevision.load(std::memory_order_acquire);
+}
+
 void initParameters(int _argc, char*_argv[], bool forceReload){
   static bool wasInitialized=false;
   if(wasInitialized&&!forceReload) return;
   wasInitialized=true;
 
-  auto P = parameterGraph();
+  auto P = getParameters();
   if(forceReload) P->clear();
 
   //-- parse cmd line arguments into graph
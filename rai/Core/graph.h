@@ -23,6 +23,7 @@ struct Graph;
 struct ParseInfo;
 struct RenderingInfo;
 struct GraphEditCallback;
+struct KeyIndex;
 typedef Array<Node*> NodeL;
 typedef Array<GraphEditCallback*> GraphEditCallbackL;
 }
@@ -35,11 +36,15 @@ namespace rai {
 struct Node {
   const std::type_info& type;
   Graph& container;
-  String key;
+ private:
+  String keyString;
+ public:
+  const String& key; ///< read-only: change it with setKey, which keeps the container's key index consistent
   NodeL parents;
   NodeL children;
   uint numChildren=0;
   uint index;
+  uint64_t keyHash=0; ///< hash under which this node is in container.keyIndex (0: not indexed)
 
   Node(const std::type_info& _type, Graph& _container, const char* _key, const NodeL& _parents);
   virtual ~Node();
@@ -47,6 +52,7 @@ struct Node {
   void addParent(Node* p, bool prepend=false);
   void removeParent(Node* p);
   void swapParent(uint i, Node* p);
+  void setKey(const char* _key); ///< change the key
 
   //-- get value
   template<class T> bool isOfType() const { return type==typeid(T); }
@@ -97,6 +103,10 @@ struct Graph : NodeL {
   ArrayG<ParseInfo>* pi;     ///< optional annotation of nodes: when detailed file parsing is enabled
   ArrayG<RenderingInfo>* ri; ///< optional annotation of nodes: dot style commands
 
+  KeyIndex* keyIndex;        ///< hash from keys to nodes, used by the find methods; built once the graph has keyIndexMinN nodes
+  bool useKeyIndex=true;     ///< (use setKeyIndex) if false, lookups scan all nodes
+  static uint keyIndexMinN;
+
   //-- constructors
   Graph();                                               ///< empty graph
   explicit Graph(const char* filename, bool parseInfo=false);         ///< read from a file
@@ -126,6 +136,10 @@ struct Graph : NodeL {
   //-- deleting nodes
   void delNode(Node* n) { CHECK(n, "can't delete NULL"); delete n; }
 
+  //-- key index
+  void setKeyIndex(bool enable); ///< enable (default) or disable and drop the key index
+  void rebuildKeyIndex();        ///< needed only after permuting the node list directly
+
   //-- basic node retrieval -- users should use the higher-level wrappers below
   Node* findNode(const char* key, bool recurseUp=false, bool recurseDown=false) const;   ///< returns nullptr if not found
   NodeL findNodes(const char* key, bool recurseUp=false, bool recurseDown=false) const;
@@ -316,8 +330,21 @@ stdOutPipe(RenderingInfo)
 
 //===========================================================================
 
-/// global registry of parameters (taken from cmd line or file) as a singleton graph
-Mutex::TypedToken<rai::Graph> getParameters();
+/// write access to the parameter graph: releasing it bumps the parameter revision (still under the lock, after all
+/// modifications made through it)
+struct ParametersToken : Mutex::TypedToken<rai::Graph> {
+  ParametersToken(Mutex::TypedToken<rai::Graph>&& token) : Mutex::TypedToken<rai::Graph>(std::move(token)) {}
+  ParametersToken(ParametersToken&&) = default;
+  ~ParametersToken();
+};
+
+/// global registry of parameters (taken from cmd line or file) as a singleton graph, for modification;
+/// use readParameters() for lookups, which does not invalidate the cached getParameter results
+ParametersToken getParameters();
+/// locked access for lookups only -- does not bump the revision, so the graph must not be modified through it
+Mutex::TypedToken<rai::Graph> readParameters();
+/// revision counter of the parameter graph, used to invalidate cached getParameter results
+uint64_t getParametersRevision();
 void initParameters(int _argc, char* _argv[], bool forceReload=false);
 
 //===========================================================================
@@ -0,0 +1,186 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#include "array.h"
+#include "util.h"
+
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <algorithm>
+#include <iomanip>
+
+#ifndef RAI_MSVC
+#  include <execinfo.h>
+#  include <dlfcn.h>
+#  include <cxxabi.h>
+#endif
+
+//===========================================================================
+//
+// allocation profiler for rai::Array
+//
+// A call site is identified by the innermost return addresses of the allocating call (so the same line reached
+// through different resize/append wrappers is one site per wrapper). Sites are labeled in the report by the
+// first frame that is not an rai::Array member; 'addr2line -e <lib> <offset>' gives file:line.
+//
+
+namespace {
+
+const uint siteDepth=4;
+
+struct Site {
+  void* frames[siteDepth];
+  const char* type;
+  bool operator<(const Site& s) const {
+    if(type!=s.type) return type<s.type;
+    return std::lexicographical_compare(frames, frames+siteDepth, s.frames, s.frames+siteDepth);
+  }
+};
+
+struct Stats {
+  uint64_t allocs=0, frees=0, bytes=0, live=0, peak=0;
+  void alloc(uint64_t b) { allocs++; bytes+=b; live+=b; if(live>peak) peak=live; }
+  void free(uint64_t b) { frees++; live-=b; }
+};
+
+struct Allocation {
+  Stats* site;
+  Stats* type;
+  uint64_t bytes;
+};
+
+struct Profile {
+  std::mutex mutex;
+  std::map<Site, Stats> sites;
+  std::map<const char*, Stats> types; //tracked separately: a type's peak is not the sum of its sites' peaks
+  std::unordered_map<void*, Allocation> live; //allocated pointer -> stats it is counted in
+  Stats total;
+};
+
+Profile& profile() {
+  static Profile* P = new Profile; //never deleted: arrays may still be freed during static destruction
+  return *P;
+}
+
+std::string demangle(const char* name) {
+#ifndef RAI_MSVC
+  int status;
+  char* s = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if(s) { std::string str(s); free(s); return str; }
+#endif
+  return name;
+}
+
+/// "function+0xoff" or "library(+0xoff)" for a return address
+std::string symbolize(void* addr) {
+#ifndef RAI_MSVC
+  Dl_info info;
+  if(dladdr(addr, &info)) {
+    std::ostringstream os;
+    if(info.dli_sname) os <<demangle(info.dli_sname) <<"+0x" <<std::hex <<((char*)addr-(char*)info.dli_saddr);
+    else os <<(info.dli_fname?info.dli_fname:"?") <<"(+0x" <<std::hex <<((char*)addr-(char*)info.dli_fbase) <<')';
+    return os.str();
+  }
+#endif
+  std::ostringstream os;
+  os <<addr;
+  return os.str();
+}
+
+std::string siteLabel(const Site& s) {
+  std::string first;
+  for(uint i=0; i<siteDepth && s.frames[i]; i++) {
+    std::string str = symbolize(s.frames[i]);
+    if(!i) first=str;
+    if(str.compare(0, 11, "rai::Array<")) return str;
+  }
+  return first;
+}
+
+std::string mb(uint64_t bytes) {
+  std::ostringstream os;
+  os <<std::fixed <<std::setprecision(3) <<double(bytes)/(1<<20);
+  return os.str();
+}
+
+}//namespace
+
+void rai::memoryProfile_alloc(void* p, uint64_t bytes, const char* type) {
+  Site site;
+  memset(site.frames, 0, sizeof(site.frames));
+  site.type = type;
+#ifndef RAI_MSVC
+  void* stack[siteDepth+1];
+  int n = backtrace(stack, siteDepth+1);
+  for(int i=1; i<n; i++) site.frames[i-1] = stack[i]; //skip this function
+#endif
+  Profile& P = profile();
+  std::lock_guard<std::mutex> lock(P.mutex);
+  Stats& s = P.sites[site];
+  Stats& t = P.types[type];
+  s.alloc(bytes);
+  t.alloc(bytes);
+  P.total.alloc(bytes);
+  P.live[p] = {&s, &t, bytes};
+}
+
+void rai::memoryProfile_free(void* p) {
+  Profile& P = profile();
+  std::lock_guard<std::mutex> lock(P.mutex);
+  auto it = P.live.find(p);
+  if(it==P.live.end()) return; //allocated before profiling was enabled
+  Allocation& a = it->second;
+  a.site->free(a.bytes);
+  a.type->free(a.bytes);
+  P.total.free(a.bytes);
+  P.live.erase(it);
+}
+
+void rai::memoryProfileReset() {
+  Profile& P = profile();
+  std::lock_guard<std::mutex> lock(P.mutex);
+  P.live.clear();
+  P.sites.clear();
+  P.types.clear();
+  P.total = Stats();
+}
+
+void rai::memoryProfileReport(std::ostream& os, uint top) {
+  Profile& P = profile();
+  std::lock_guard<std::mutex> lock(P.mutex);
+
+  std::vector<std::pair<const Site*, const Stats*>> sites;
+  for(auto& s:P.sites) sites.push_back({&s.first, &s.second});
+  auto moreBytes = [](const std::pair<const Site*, const Stats*>& a, const std::pair<const Site*, const Stats*>& b) { return a.second->bytes>b.second->bytes; };
+  std::sort(sites.begin(), sites.end(), moreBytes);
+
+  os <<"\n*** rai::Array allocation profile: " <<P.total.allocs <<" allocations, " <<mb(P.total.bytes) <<"MB allocated, "
+     <<mb(P.total.peak) <<"MB peak live, " <<mb(P.total.live) <<"MB still live" <<endl;
+  os <<"-- per type\n";
+  std::vector<std::pair<const char*, Stats>> typeList(P.types.begin(), P.types.end());
+  std::sort(typeList.begin(), typeList.end(), [](const std::pair<const char*, Stats>& a, const std::pair<const char*, Stats>& b) { return a.second.bytes>b.second.bytes; });
+  for(auto& t:typeList) {
+    os <<std::setw(10) <<t.second.allocs <<" allocs " <<std::setw(10) <<mb(t.second.bytes) <<"MB  peak " <<std::setw(9) <<mb(t.second.peak)
+       <<"MB  live " <<std::setw(9) <<mb(t.second.live) <<"MB  " <<demangle(t.first) <<'\n';
+  }
+  os <<"-- top " <<top <<" call sites\n";
+  for(uint i=0; i<sites.size() && i<top; i++) {
+    const Stats& s = *sites[i].second;
+    os <<std::setw(10) <<s.allocs <<" allocs " <<std::setw(10) <<mb(s.bytes) <<"MB  peak " <<std::setw(9) <<mb(s.peak)
+       <<"MB  live " <<std::setw(9) <<mb(s.live) <<"MB  " <<demangle(sites[i].first->type) <<"  " <<siteLabel(*sites[i].first) <<'\n';
+  }
+  os <<std::flush;
+}
+
+RUN_ON_INIT_BEGIN(memprofile)
+if(getenv("RAI_MEMPROFILE")) {
+  rai::globalMemoryProfile=true;
+  atexit([]() { rai::memoryProfileReport(std::cerr); });
+}
+RUN_ON_INIT_END(memprofile)
@@ -0,0 +1,179 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#include "array.h"
+
+//===========================================================================
+//
+// double/float versions of the rai::simd kernels
+//
+// The kernels are written on 64-byte vector types (8 doubles or 16 floats) and compiled as AVX-512, AVX2 and
+// default (SSE2) clones; the loader picks the widest clone the CPU supports. Since the vector width is fixed,
+// every clone performs exactly the same lane-wise operations in the same order (8 or 16 partial sums, combined
+// by a fixed pairwise tree, plus a sequential tail), so reductions return bit-identical results on all ISAs.
+// For the same reason multiply-adds must not be contracted into FMAs, which only some of the clones have.
+//
+
+#pragma GCC optimize ("fp-contract=off")
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(RAI_NO_SIMD_DISPATCH)
+#  define RAI_SIMD_DISPATCH __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#  define RAI_SIMD_DISPATCH
+#endif
+
+//the helpers pass 64-byte vectors by value: they must be inlined into each clone, never called across ISAs
+#define RAI_SIMD_INLINE inline __attribute__((always_inline))
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace {
+
+typedef double vd __attribute__((vector_size(64)));
+typedef float vf __attribute__((vector_size(64)));
+typedef long long vdi __attribute__((vector_size(64)));
+typedef int vfi __attribute__((vector_size(64)));
+
+template<class T> struct Vec;
+template<> struct Vec<double> { typedef vd V; enum { L=8 }; };
+template<> struct Vec<float> { typedef vf V; enum { L=16 }; };
+
+template<class V, class T> RAI_SIMD_INLINE V load(const T* x) { V v; memcpy(&v, x, sizeof(V)); return v; }
+template<class V, class T> RAI_SIMD_INLINE void store(T* x, const V& v) { memcpy(x, &v, sizeof(V)); }
+
+RAI_SIMD_INLINE vd vabs(const vd& a) { return (vd)((vdi)a & 0x7fffffffffffffffLL); }
+RAI_SIMD_INLINE vf vabs(const vf& a) { return (vf)((vfi)a & 0x7fffffff); }
+RAI_SIMD_INLINE double vabs(double a) { return std::fabs(a); }
+RAI_SIMD_INLINE float vabs(float a) { return std::fabs(a); }
+
+struct Id { template<class V> RAI_SIMD_INLINE V operator()(const V& a) const { return a; } };
+struct Sqr { template<class V> RAI_SIMD_INLINE V operator()(const V& a) const { return a*a; } };
+struct Abs { template<class V> RAI_SIMD_INLINE V operator()(const V& a) const { return vabs(a); } };
+struct Pos { template<class V> RAI_SIMD_INLINE V operator()(const V& a) const { return a>0 ? a : V{}; } };
+struct Prod { template<class V> RAI_SIMD_INLINE V operator()(const V& a, const V& b) const { return a*b; } };
+struct SqrDiff { template<class V> RAI_SIMD_INLINE V operator()(const V& a, const V& b) const { V d=a-b; return d*d; } };
+
+struct Add { template<class V, class S> RAI_SIMD_INLINE V operator()(const V& a, const S& b) const { return a+b; } };
+struct Sub { template<class V, class S> RAI_SIMD_INLINE V operator()(const V& a, const S& b) const { return a-b; } };
+struct Mul { template<class V, class S> RAI_SIMD_INLINE V operator()(const V& a, const S& b) const { return a*b; } };
+struct Div { template<class V, class S> RAI_SIMD_INLINE V operator()(const V& a, const S& b) const { return a/b; } };
+struct Min { template<class V> RAI_SIMD_INLINE V operator()(const V& a, const V& b) const { return a<b ? a : b; } };
+struct Max { template<class V> RAI_SIMD_INLINE V operator()(const V& a, const V& b) const { return a>b ? a : b; } };
+
+/// fixed pairwise combination of the lanes
+template<class T, class V> RAI_SIMD_INLINE T laneSum(const V& a) {
+  const uint L=Vec<T>::L;
+  T s[L];
+  memcpy(s, &a, sizeof(V));
+  for(uint w=L/2; w; w/=2) for(uint i=0; i<w; i++) s[i] += s[i+w];
+  return s[0];
+}
+
+template<class T, class F> RAI_SIMD_INLINE T reduce(const T* x, uint n, const F& f) {
+  typedef typename Vec<T>::V V;
+  const uint L=Vec<T>::L;
+  uint i=0;
+  T s=0;
+  if(n>=L) {
+    V acc = f(load<V>(x));
+    for(i=L; i+L<=n; i+=L) acc += f(load<V>(x+i));
+    s = laneSum<T>(acc);
+  }
+  for(; i<n; i++) s += f(x[i]);
+  return s;
+}
+
+template<class T, class F> RAI_SIMD_INLINE T reduce(const T* x, const T* y, uint n, const F& f) {
+  typedef typename Vec<T>::V V;
+  const uint L=Vec<T>::L;
+  uint i=0;
+  T s=0;
+  if(n>=L) {
+    V acc = f(load<V>(x), load<V>(y));
+    for(i=L; i+L<=n; i+=L) acc += f(load<V>(x+i), load<V>(y+i));
+    s = laneSum<T>(acc);
+  }
+  for(; i<n; i++) s += f(x[i], y[i]);
+  return s;
+}
+
+/// max of |x_i|; like the scalar version, NaNs are skipped unless x_0 is NaN
+template<class T> RAI_SIMD_INLINE T absMaxImpl(const T* x, uint n) {
+  typedef typename Vec<T>::V V;
+  const uint L=Vec<T>::L;
+  if(!n) return 0;
+  uint i=0;
+  T m=vabs(x[0]);
+  if(n>=L) {
+    V acc = vabs(load<V>(x));
+    for(i=L; i+L<=n; i+=L) { V a=vabs(load<V>(x+i)); acc = a>acc ? a : acc; }
+    T s[L];
+    memcpy(s, &acc, sizeof(V));
+    m = s[0];
+    for(uint j=1; j<L; j++) if(s[j]>m) m=s[j];
+  }
+  for(; i<n; i++) { T a=vabs(x[i]); if(a>m) m=a; }
+  return m;
+}
+
+template<class T, class F> RAI_SIMD_INLINE void update(T* x, const T* y, uint n, const F& f) {
+  typedef typename Vec<T>::V V;
+  const uint L=Vec<T>::L;
+  uint i=0;
+  for(; i+L<=n; i+=L) store(x+i, f(load<V>(x+i), load<V>(y+i)));
+  for(; i<n; i++) x[i] = f(x[i], y[i]);
+}
+
+template<class T, class F> RAI_SIMD_INLINE void update(T* x, T y, uint n, const F& f) {
+  typedef typename Vec<T>::V V;
+  const uint L=Vec<T>::L;
+  uint i=0;
+  for(; i+L<=n; i+=L) store(x+i, f(load<V>(x+i), y));
+  for(; i<n; i++) x[i] = f(x[i], y);
+}
+
+template<class T, class F> RAI_SIMD_INLINE void binary(T* z, const T* x, const T* y, uint n, const F& f) {
+  typedef typename Vec<T>::V V;
+  const uint L=Vec<T>::L;
+  uint i=0;
+  for(; i+L<=n; i+=L) store(z+i, f(load<V>(x+i), load<V>(y+i)));
+  for(; i<n; i++) z[i] = f(x[i], y[i]);
+}
+
+}//namespace
+
+//===========================================================================
+
+namespace rai {
+namespace simd {
+
+#define RAI_SIMD_DEFS(T) \
+  RAI_SIMD_DISPATCH T sum(const T* x, uint n) { return reduce(x, n, Id()); } \
+  RAI_SIMD_DISPATCH T sumOfSqr(const T* x, uint n) { return reduce(x, n, Sqr()); } \
+  RAI_SIMD_DISPATCH T sumOfAbs(const T* x, uint n) { return reduce(x, n, Abs()); } \
+  RAI_SIMD_DISPATCH T sumOfPos(const T* x, uint n) { return reduce(x, n, Pos()); } \
+  RAI_SIMD_DISPATCH T absMax(const T* x, uint n) { return absMaxImpl(x, n); } \
+  RAI_SIMD_DISPATCH T scalarProduct(const T* x, const T* y, uint n) { return reduce(x, y, n, Prod()); } \
+  RAI_SIMD_DISPATCH T sqrDistance(const T* x, const T* y, uint n) { return reduce(x, y, n, SqrDiff()); } \
+  RAI_SIMD_DISPATCH void add(T* x, const T* y, uint n) { update(x, y, n, Add()); } \
+  RAI_SIMD_DISPATCH void sub(T* x, const T* y, uint n) { update(x, y, n, Sub()); } \
+  RAI_SIMD_DISPATCH void mul(T* x, const T* y, uint n) { update(x, y, n, Mul()); } \
+  RAI_SIMD_DISPATCH void div(T* x, const T* y, uint n) { update(x, y, n, Div()); } \
+  RAI_SIMD_DISPATCH void add(T* x, T y, uint n) { update(x, y, n, Add()); } \
+  RAI_SIMD_DISPATCH void sub(T* x, T y, uint n) { update(x, y, n, Sub()); } \
+  RAI_SIMD_DISPATCH void mul(T* x, T y, uint n) { update(x, y, n, Mul()); } \
+  RAI_SIMD_DISPATCH void div(T* x, T y, uint n) { update(x, y, n, Div()); } \
+  RAI_SIMD_DISPATCH void min(T* z, const T* x, const T* y, uint n) { binary(z, x, y, n, Min()); } \
+  RAI_SIMD_DISPATCH void max(T* z, const T* x, const T* y, uint n) { binary(z, x, y, n, Max()); }
+
+RAI_SIMD_DEFS(double)
+RAI_SIMD_DEFS(float)
+
+#undef RAI_SIMD_DEFS
+
+}//namespace simd
+}//namespace rai
@@ -24,6 +24,11 @@
 #  define getpid _getpid
 #endif
 #include <errno.h>
+#ifdef __linux__
+#  include <sched.h>
+#  include <time.h>
+#  include <sys/mman.h>
+#endif
 
 //===========================================================================
 
@@ -270,6 +275,7 @@ int Var_base::deAccess(Thread* th) {
   int i;
   if(rwlock.rwCount == -1) { //log a revision after write access
     i = revision++;
+    if(publish) publish();
     for(auto* c:callbacks) c->call()(this);
   } else {
     i = revision;
@@ -290,26 +296,76 @@ Metronome::Metronome(double ticIntervalSec) {
 void Metronome::reset(double ticIntervalSec) {
   tics=0;
   ticInterval = ticIntervalSec;
-  ticTime = std::chrono::high_resolution_clock::now();
+  ticTime = std::chrono::steady_clock::now();
+  latency.reset();
 }
 
 void Metronome::waitForTic() {
   auto interval = std::chrono::duration<double>(ticInterval);
   ticTime += interval;
-  std::chrono::time_point<std::chrono::high_resolution_clock, std::chrono::duration<double>> now = std::chrono::high_resolution_clock::now();
+  std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> now = std::chrono::steady_clock::now();
   if(ticTime>now){
+#ifdef __linux__
+    //steady_clock is CLOCK_MONOTONIC: sleep until the absolute deadline
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(ticTime.time_since_epoch()).count();
+    timespec deadline;
+    deadline.tv_sec = ns/1000000000;
+    deadline.tv_nsec = ns%1000000000;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr)==EINTR) {}
+#else
     std::this_thread::sleep_until(ticTime);
+#endif
+    latency.add(std::chrono::duration<double>(std::chrono::steady_clock::now()-ticTime).count());
   }else{
+    latency.misses++;
+    latency.add((now-ticTime).count());
     ticTime = now;
   }
   tics++;
 }
 
 double Metronome::getTimeSinceTic() {
-  auto now = std::chrono::high_resolution_clock::now();
+  auto now = std::chrono::steady_clock::now();
   return std::chrono::duration<double>(ticTime-now).count();
 }
 
+void LatencyHistogram::reset() {
+  for(auto& c:counts) c=0;
+  n=misses=maxNs=0;
+}
+
+void LatencyHistogram::add(double sec) {
+  uint64_t ns = sec>0. ? uint64_t(sec*1e9) : 0;
+  uint i=0;
+  for(uint64_t us=ns/1000; us && i<N-1; us>>=1) i++;
+  counts[i]++;
+  n++;
+  for(uint64_t m=maxNs; ns>m && !maxNs.compare_exchange_weak(m, ns);) {}
+}
+
+double LatencyHistogram::quantile(double q) const {
+  uint64_t sum=0;
+  for(uint i=0; i<N; i++) {
+    sum += counts[i];
+    if(sum>=q*n) return 1e-6*(uint64_t(1)<<i);
+  }
+  return 1e-6*(uint64_t(1)<<(N-1));
+}
+
+rai::String LatencyHistogram::report() const {
+  rai::String s;
+  s.printf("tics=%lu misses=%lu p50<%gus p99<%gus max=%.1fus", (unsigned long)n, (unsigned long)misses, 1e6*quantile(.5), 1e6*quantile(.99), 1e-3*maxNs);
+  return s;
+}
+
+bool lockMemory() {
+#ifdef __linux__
+  if(!mlockall(MCL_CURRENT|MCL_FUTURE)) return true;
+  LOG(-1) <<"mlockall failed: " <<strerror(errno);
+#endif
+  return false;
+}
+
 //===========================================================================
 //
 // CycleTimer
@@ -395,6 +451,7 @@ Thread::~Thread() {
   }
 
 void Thread::threadOpen(bool wait, int priority) {
+  if(priority>0) rtPriority=priority;
   {
     auto lock = event.statusMutex(RAI_HERE);
     if(thread) return; //this is already open -- or has just beend opened (parallel call to threadOpen)
@@ -409,6 +466,7 @@ void Thread::threadOpen(bool wait, int priority) {
 
   if(metronome.ticInterval>0.) {
     if(metronome.ticInterval>1e-10) {
+      metronome.reset(metronome.ticInterval); //start the schedule now
       event.setStatus(tsBEATING);
     } else {
       event.setStatus(tsLOOPING);
@@ -462,6 +520,13 @@ bool Thread::isClosed() {
   return !thread; //getStatus()==tsIsClosed;
 }
 
+rai::String Thread::report() {
+  rai::String s;
+  s <<name <<": " <<timer.report();
+  if(metronome.ticInterval>1e-10) s <<" latency: " <<metronome.latency.report();
+  return s;
+}
+
 void Thread::waitForOpened() {
   event.waitForStatusNotEq(tsIsClosed);
   event.waitForStatusNotEq(tsToOpen);
@@ -474,6 +539,7 @@ void Thread::waitForIdle() {
 void Thread::threadLoop(bool waitForOpened) {
   threadOpen(waitForOpened);
   if(metronome.ticInterval>1e-10) {
+    if(event.getStatus()!=tsBEATING) metronome.reset(metronome.ticInterval); //start the schedule now
     event.setStatus(tsBEATING);
   } else {
     event.setStatus(tsLOOPING);
@@ -490,9 +556,21 @@ void Thread::threadStop(bool wait) {
 void Thread::main() {
   tid = getpid();
 //  if(verbose>0) cout <<"*** Entering Thread '" <<name <<"'" <<endl;
-  //http://linux.die.net/man/3/setpriority
-  //if(Thread::threadPriority) setRRscheduling(Thread::threadPriority);
-  //if(Thread::threadPriority) setNice(Thread::threadPriority);
+#ifdef __linux__
+  if(cpus.N) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(uint c:cpus) CPU_SET(c, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if(rc) LOG(-1) <<"could not pin thread '" <<name <<"' to cpus " <<cpus <<": " <<strerror(rc);
+  }
+  if(rtPriority>0) {
+    sched_param param;
+    param.sched_priority = rtPriority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if(rc) LOG(-1) <<"could not set SCHED_FIFO priority " <<rtPriority <<" for thread '" <<name <<"': " <<strerror(rc);
+  }
+#endif
 
   {
     auto mux = stepMutex(RAI_HERE);
@@ -543,6 +621,140 @@ void Thread::main() {
   event.setStatus(tsIsClosed);
 }
 
+//===========================================================================
+//
+// ThreadPool
+//
+
+static thread_local const rai::ThreadPool* threadPool_pool=nullptr; //the pool the calling thread is a worker of
+static thread_local uint threadPool_slot=0;
+static std::atomic<uint> threadPool_outsideThreads(0); //outside ids are handed out on first use
+static thread_local int threadPool_outsideId=-1;
+
+rai::ThreadPool::ThreadPool(int nThreads) : queued(0) {
+  if(nThreads<=0) nThreads = rai::getParameter<int>("threads", rai::MAX(1, (int)std::thread::hardware_concurrency()));
+  queues.resize(nThreads);
+  for(ptr<Queue>& q:queues) q = make_shared<Queue>();
+  for(uint i=1; i<queues.size(); i++) workers.push_back(make_shared<std::thread>(&ThreadPool::loop, this, i));
+}
+
+rai::ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stop=true;
+  }
+  wakeup.notify_all();
+  for(ptr<std::thread>& th:workers) th->join();
+}
+
+uint rai::ThreadPool::workerIndex() const { return threadPool_pool==this ? threadPool_slot : 0; }
+
+uint rai::ThreadPool::scratchIndex() const {
+  if(threadPool_pool==this) return threadPool_slot;
+  if(threadPool_outsideId<0) threadPool_outsideId = threadPool_outsideThreads++;
+  return threadPool_outsideId ? nThreads()-1+threadPool_outsideId : 0;
+}
+
+void rai::ThreadPool::submit(const Task& task) {
+  uint slot = workerIndex();
+  {
+    std::lock_guard<std::mutex> lock(queues[slot]->mutex);
+    queues[slot]->tasks.push_back(task);
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    queued++;
+  }
+  wakeup.notify_one();
+}
+
+bool rai::ThreadPool::runOne() {
+  uint self = workerIndex();
+  Task task;
+  for(uint k=0; k<queues.size() && !task; k++) {
+    Queue& q = *queues[(self+k)%queues.size()];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if(!q.tasks.size()) continue;
+    if(!k) { task = std::move(q.tasks.back()); q.tasks.pop_back(); } //own queue: LIFO
+    else { task = std::move(q.tasks.front()); q.tasks.pop_front(); } //steal: FIFO
+  }
+  if(!task) return false;
+  queued--;
+  task();
+  return true;
+}
+
+void rai::ThreadPool::loop(uint slot) {
+  threadPool_pool = this;
+  threadPool_slot = slot;
+  for(;;) {
+    if(runOne()) continue;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wakeup.wait(lock, [this]() { return stop || queued>0; });
+    if(stop) return;
+  }
+}
+
+rai::ThreadPool& rai::threadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+void rai::TaskGroup::run(const std::function<void()>& f) {
+  pending++;
+  pool.submit([this, f]() {
+    try {
+      f();
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(!error) error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!--pending) done.notify_all();
+  });
+}
+
+rai::TaskGroup::~TaskGroup() {
+  if(!pending && !error) return;
+  try {
+    join();
+  } catch(const std::exception& e) {
+    LOG(-1) <<"exception of a task that was never joined: " <<e.what();
+  } catch(...) {
+    LOG(-1) <<"exception of a task that was never joined";
+  }
+}
+
+void rai::TaskGroup::join() {
+  while(pending) {
+    if(pool.runOne()) continue;
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return !pending; }); //recheck for stealable tasks now and then
+  }
+  std::exception_ptr e;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(e, error);
+  }
+  if(e) std::rethrow_exception(e);
+}
+
+void rai::parallel_for(uint lo, uint up, const std::function<void(uint i)>& f, uint grain, ThreadPool& pool) {
+  if(up<=lo) return;
+  uint n = up-lo;
+  if(!grain) grain = rai::MAX(1u, n/(4*pool.nThreads()));
+  if(pool.nThreads()==1 || grain>=n) {
+    for(uint i=lo; i<up; i++) f(i);
+    return;
+  }
+  TaskGroup group(pool);
+  for(uint l=lo; l<up; l+=grain) {
+    uint u = rai::MIN(up, l+grain);
+    group.run([&f, l, u]() { for(uint i=l; i<u; i++) f(i); });
+  }
+  group.join();
+}
+
 //===========================================================================
 //
 // controlling threads
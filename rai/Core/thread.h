@@ -16,6 +16,9 @@
 #include <shared_mutex>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
+#include <deque>
+#include <map>
 
 enum ThreadState { tsIsClosed=-6, tsToOpen=-1, tsLOOPING=-2, tsBEATING=-3, tsIDLE=0, tsToStep=1, tsToClose=-4,  tsFAILURE=-5,  }; //positive states indicate steps-to-go
 struct Signaler;
@@ -75,6 +78,7 @@ struct Var_base : NonCopyable {
   double write_time=0.;        ///< clock time of last write access
   double data_time=0.;         ///< time stamp of the original data source
   CallbackL<void(Var_base*)> callbacks;
+  std::function<void()> publish; ///< lock-free mode only: called at the end of each write access, before callbacks
 
   Var_base(const char* _name=0);
   /// @name c'tor/d'tor
@@ -98,12 +102,17 @@ struct RToken {
   Var_base* var;
   T* data;
   Thread* th;
+  double data_time;                        ///< data time stamp of the read revision
+  std::atomic<int>* slotReaders=nullptr;   ///< lock-free mode: reference count of the read slot instead of the rwlock
   RToken(Var_base& _var, T* _data, Thread* _th=nullptr, int* getRevision=nullptr, bool isAlreadyLocked=false)
     : var(&_var), data(_data), th(_th) {
     if(!isAlreadyLocked) var->readAccess(th);
     if(getRevision) *getRevision=var->revision;
+    data_time = var->data_time;
   }
-  ~RToken() { var->deAccess(th); }
+  RToken(std::atomic<int>& _slotReaders, T* _data, double _data_time)
+    : var(nullptr), data(_data), th(nullptr), data_time(_data_time), slotReaders(&_slotReaders) {}
+  ~RToken() { if(slotReaders) slotReaders->fetch_sub(1); else var->deAccess(th); }
   const T* operator->() { return data; }
   operator const T& () { return *data; }
   const T& operator()() { return *data; }
@@ -139,10 +148,20 @@ template<class T>
 struct Var_data : Var_base {
   T data;
 
-  Var_data(const char* name=0) : Var_base(name), data() {} // default constructor for value always initializes, also primitive types 'bool' or 'int'
+  /// lock-free mode: each write publishes a copy of data into a free slot; readers reference-count the latest slot
+  struct Slot { T data; std::atomic<int> readers; int revision; double data_time; };
+  std::unique_ptr<Slot[]> slots;
+  uint slotsN=0;
+  std::atomic<int> latest;
+
+  Var_data(const char* name=0) : Var_base(name), data(), latest(-1) {} // default constructor for value always initializes, also primitive types 'bool' or 'int'
   ~Var_data() {
       if (rwlock.isLocked()) { std::cerr << "can't destroy a variable when it is currently accessed!" << endl; exit(1); }
   }
+
+  void setLockFree(uint maxReaders);
+  Slot& readLatest();
+  void publishSlot();
 };
 
 template<class T> bool operator==(const Var_data<T>&, const Var_data<T>&) { return false; }
@@ -185,7 +204,10 @@ struct Var {
   T& operator()() { CHECK(data->rwlock.isLocked(), "direct variable access without locking it before");  return data->data; }
   T& operator*() {  CHECK(data->rwlock.isLocked(), "direct variable access without locking it before");  return data->data; }
   T* operator->() { CHECK(data->rwlock.isLocked(), "direct variable access without locking it before");  return &(data->data); }
-  RToken<T> get() { return RToken<T>(*data, &data->data, thread, &last_read_revision); } ///< read access to the variable's data
+  RToken<T> get() { ///< read access to the variable's data
+    if(data->slots) { auto& s=data->readLatest(); last_read_revision=s.revision; return RToken<T>(s.readers, &s.data, s.data_time); }
+    return RToken<T>(*data, &data->data, thread, &last_read_revision);
+  }
   WToken<T> set() { return WToken<T>(*data, &data->data, thread/*, &last_read_revision*/); } ///< write access to the variable's data
   WToken<T> set(const double& dataTime) { return WToken<T>(dataTime, *data, &data->data, thread/*, &last_read_revision*/); } ///< write access to the variable's data
   operator Var_base& () { return *std::dynamic_pointer_cast<Var_base>(data); }
@@ -199,7 +221,10 @@ struct Var {
   int readAccess() {  return last_read_revision = data->readAccess((Thread*)thread); }
   int writeAccess() { return data->writeAccess((Thread*)thread); }
   int deAccess() {    return data->deAccess((Thread*)thread); }
-  int getRevision() { data->rwlock.readLock(); int r=data->revision; data->rwlock.unlock(); return r; }
+  int getRevision() {
+    if(data->slots) { auto& s=data->readLatest(); int r=s.revision; s.readers--; return r; }
+    data->rwlock.readLock(); int r=data->revision; data->rwlock.unlock(); return r;
+  }
   bool hasNewRevision() { return getRevision()>last_read_revision; }
   void waitForNextRevision(uint multipleRevisions=0) { waitForRevisionGreaterThan(last_read_revision+multipleRevisions); }
   int waitForRevisionGreaterThan(int rev);
@@ -210,6 +235,12 @@ struct Var {
   }
   void stopListening();
 
+  /** switch to single-writer/multi-reader mode: get() never blocks and never blocks the writer, as it returns a
+      reference-counted snapshot of the last completed write; set() works on the writer's own copy and publishes it on
+      release. maxReaders is the number of read tokens that may be held at the same time without stalling the
+      writer. Explicit readAccess()/deAccess() still lock and see the writer's copy. */
+  void setLockFree(uint maxReaders=4) { data->setLockFree(maxReaders); }
+
   void addCallback(const std::function<void(Var_base*)>& call, const void* callbackID=0) {
     data->addCallback(call, callbackID);
   }
@@ -286,11 +317,29 @@ inline bool wait(const VarL& acts, double timeout=-1.) {
 // Timing helpers
 //
 
-/// a simple struct to realize a strict tic tac timing (called in thread::main once each step if looping)
+/// histogram of latencies in power-of-two microsecond buckets: bucket 0 counts <1us, bucket i counts [2^(i-1), 2^i)us
+struct LatencyHistogram {
+  static const uint N=24;
+  std::atomic<uint64_t> counts[N];
+  std::atomic<uint64_t> n, misses; ///< number of samples, number of missed deadlines
+  std::atomic<uint64_t> maxNs;
+
+  LatencyHistogram() { reset(); }
+  void reset();
+  void add(double sec);
+  double quantile(double q) const; ///< upper bucket edge (in sec) below which a fraction q of the samples lies
+  rai::String report() const;
+};
+
+/** a simple struct to realize a strict tic tac timing (called in thread::main once each step if looping);
+ *  tics are absolute deadlines on the monotonic clock (clock_nanosleep on Linux), so there is no drift. If a tic is
+ *  already over when waitForTic is called, it counts as a deadline miss and the schedule restarts from now. The
+ *  wake-up latency (actual wake-up minus deadline) of every tic is recorded in the histogram. */
 struct Metronome {
   double ticInterval;
-  std::chrono::time_point<std::chrono::high_resolution_clock, std::chrono::duration<double>> ticTime;
+  std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> ticTime;
   uint tics;
+  LatencyHistogram latency;
 
   Metronome(double ticIntervalSec); ///< set tic tac time in seconds
 
@@ -299,6 +348,9 @@ struct Metronome {
   double getTimeSinceTic();       ///< time since last tic
 };
 
+/// lock all current and future pages of the process in memory (mlockall), to avoid page faults in real-time loops
+bool lockMemory();
+
 //===========================================================================
 
 /// to meassure cycle and busy times
@@ -337,6 +389,10 @@ struct Thread {
   Metronome metronome;          ///< used for beat-looping
   CycleTimer timer;             ///< measure how the time spend per cycle, within step, idle
 
+  /// @name real-time scheduling, applied when the thread starts (Linux only; needs CAP_SYS_NICE or an rtprio limit)
+  int rtPriority=0;             ///< >0: run with SCHED_FIFO at this priority
+  uintA cpus;                   ///< pin the thread to these CPUs (empty: no pinning)
+
   /// @name c'tor/d'tor
   /** DON'T open drivers/devices/files or so here in the constructor,
    * but in open(). Sometimes a module might be created only to see
@@ -349,7 +405,7 @@ struct Thread {
   virtual ~Thread();
 
   /// @name to be called from `outside' (e.g. the main) to start/step/close the thread
-  void threadOpen(bool wait=false, int priority=0);      ///< start the thread (in idle mode) (should be positive for changes)
+  void threadOpen(bool wait=false, int priority=0);      ///< start the thread (in idle mode); priority>0 sets rtPriority
   void threadClose(double timeoutForce=-1.);                   ///< close the thread (stops looping and waits for idle mode before joining the thread)
   void threadStep();                    ///< trigger (multiple) step (idle -> working mode) (wait until idle? otherwise calling during non-idle -> error)
   void threadLoop(bool waitForOpened=false);  ///< loop, either with fixed beat or at full speed
@@ -360,6 +416,7 @@ struct Thread {
   void waitForIdle();                   ///< caller waits until step is done (working -> idle mode)
   bool isIdle();                        ///< check if in idle mode
   bool isClosed();                      ///< check if closed
+  rai::String report();                 ///< cycle times, and wake-up latencies and deadline misses when beating
 
   /** use this to open drivers/devices/files and initialize
    *  parameters; this is called within the thread */
@@ -407,6 +464,262 @@ inline ptr<ScriptThread> run(const std::function<int ()>& script, double beatInt
   return make_shared<ScriptThread>(script, beatIntervalSec);
 }
 
+//===========================================================================
+//
+// data-parallel work: thread pool, task groups, parallel_for, deterministic reduction
+//
+
+namespace rai {
+
+struct TaskGroup;
+
+/** A pool of worker threads. Each thread slot has its own task deque: a thread pushes and pops
+ *  at the back of its own deque, idle threads steal from the front of others'. Threads outside
+ *  the pool share the deque of slot 0 and execute tasks while they wait in TaskGroup::join; for
+ *  per-thread data each of them has its own scratchIndex, so scratch is never shared between threads. */
+struct ThreadPool : NonCopyable {
+  typedef std::function<void()> Task;
+  struct Queue { std::mutex mutex; std::deque<Task> tasks; };
+
+  std::vector<ptr<Queue>> queues;           ///< one per thread slot (std containers: the process-wide pool outlives main)
+  std::vector<ptr<std::thread>> workers;    ///< the pool threads (slots 1..nThreads-1)
+  std::mutex sleepMutex;
+  std::condition_variable wakeup;
+  std::atomic<int> queued;                  ///< number of tasks in all queues
+  bool stop=false;
+
+  ThreadPool(int nThreads=-1);              ///< nThreads<=0: parameter 'threads' (default: hardware concurrency)
+  ~ThreadPool();
+
+  uint nThreads() const { return queues.size(); }
+  uint workerIndex() const;                 ///< slot of the calling thread in this pool (0 for threads outside the pool)
+  bool isWorker() const { return workerIndex()>0; }
+  uint scratchIndex() const;                ///< workerIndex for workers; 0 for the first outside thread, >=nThreads for further ones
+
+  void submit(const Task& task);
+  bool runOne();                            ///< executes one task of the own queue or stolen; false if there was none
+
+ private:
+  void loop(uint slot);
+};
+
+/// the process-wide pool, sized by the parameter 'threads'
+ThreadPool& threadPool();
+
+/// a set of tasks that can be joined; the first exception thrown by a task is rethrown by join
+struct TaskGroup : NonCopyable {
+  ThreadPool& pool;
+  std::atomic<int> pending;
+  std::mutex mutex;
+  std::condition_variable done;
+  std::exception_ptr error;
+
+  TaskGroup(ThreadPool& _pool=threadPool()) : pool(_pool), pending(0) {}
+  ~TaskGroup();                             ///< waits for pending tasks; an exception not collected by join is logged, not rethrown
+
+  void run(const std::function<void()>& f);
+  void join();                              ///< the calling thread executes pending tasks while waiting
+};
+
+/// calls f(i) for all i in [lo,up), in chunks of grain (0: automatic)
+void parallel_for(uint lo, uint up, const std::function<void(uint i)>& f, uint grain=0, ThreadPool& pool=threadPool());
+
+/** reduce over [lo,up): map(l,u) computes the partial result of a chunk, partials are combined serially in chunk order;
+ *  the chunking depends only on chunk, not on the number of threads, so the result is identical for any pool size */
+template<class T> T parallel_reduce(uint lo, uint up, const T& init,
+                                    const std::function<T(uint l, uint u)>& map,
+                                    const std::function<T(const T& a, const T& b)>& reduce,
+                                    uint chunk=256, ThreadPool& pool=threadPool()) {
+  if(up<=lo) return init;
+  CHECK(chunk, "chunk size must be positive");
+  uint n = (up-lo+chunk-1)/chunk;
+  rai::Array<T> partial(n);
+  parallel_for(0, n, [&](uint c) { partial(c) = map(lo+c*chunk, rai::MIN(up, lo+(c+1)*chunk)); }, 1, pool);
+  T x = init;
+  for(uint c=0; c<n; c++) x = reduce(x, partial(c));
+  return x;
+}
+
+/// per-thread scratch storage: each thread accesses its own element
+template<class T> struct WorkerScratch {
+  ThreadPool& pool;
+  rai::Array<T> slots;          ///< one per thread slot of the pool
+  std::map<uint, T> outside;    ///< further threads outside the pool, by scratchIndex
+  std::mutex outsideMutex;
+  WorkerScratch(ThreadPool& _pool=threadPool()) : pool(_pool) { slots.resize(pool.nThreads()); }
+  T& operator()() {
+    uint i = pool.scratchIndex();
+    if(i<slots.N) return slots(i);
+    std::lock_guard<std::mutex> lock(outsideMutex);
+    return outside[i];
+  }
+  template<class F> void forAll(const F& f) { for(T& x:slots) f(x); for(auto& x:outside) f(x.second); }
+};
+
+//===========================================================================
+//
+// message queues
+//
+
+/// what push does when the queue is full
+enum QueuePolicy { QP_dropOldest, QP_block, QP_reject };
+
+/** A bounded lock-free message queue (ring buffer with per-cell sequence numbers), for any number of producers and
+ *  consumers (typically SPSC or MPSC between pipeline stages). Unlike a Var, every message is delivered once, unless
+ *  the dropOldest policy discards it. push/pop never take a lock unless they block or someone is waiting.
+ *  Listening signalers (e.g., a Thread's event) get their status incremented for each message, so a listening
+ *  thread steps once per message -- stop listening before closing it. Use T=ptr<...> or move-push to avoid copying
+ *  large messages. */
+template<class T> struct MessageQueue : NonCopyable {
+  struct Cell { std::atomic<uint64_t> seq; T msg; int64_t pushTime; };
+  std::unique_ptr<Cell[]> cells;
+  uint64_t mask;
+  QueuePolicy policy;
+  alignas(64) std::atomic<uint64_t> head; ///< next push position
+  alignas(64) std::atomic<uint64_t> tail; ///< next pop position
+
+  //-- counters
+  std::atomic<uint64_t> pushed, popped, dropped, rejected;
+  std::atomic<uint64_t> latencySum, latencyMax; ///< push-to-pop latency in nanoseconds
+
+  //-- wake-up of blocked push/pop calls and listeners
+  Signaler changed;
+  std::atomic<int> waiting;
+  Mutex listenersMutex;
+  SignalerL listeners;
+  std::atomic<uint> listenersN;
+
+  MessageQueue(uint capacity=64, QueuePolicy _policy=QP_dropOldest);
+
+  bool push(const T& msg, double timeout=-1.) { T m(msg); return push(std::move(m), timeout); }
+  bool push(T&& msg, double timeout=-1.); ///< false if rejected (QP_reject, or QP_block timed out)
+  bool pop(T& msg, double timeout=0.);   ///< timeout=0: non-blocking, <0: wait forever; false if empty
+  bool tryPush(T& msg);                   ///< lock-free; moves msg in on success
+  bool tryPop(T& msg);                    ///< lock-free
+
+  uint capacity() const { return mask+1; }
+  uint depth() const { uint64_t h=head, t=tail; return h>t ? h-t : 0; }
+  double meanLatency() const { return popped ? 1e-9*latencySum/popped : 0.; }
+  double maxLatency() const { return 1e-9*latencyMax; }
+  void resetCounters() { pushed=popped=dropped=rejected=latencySum=latencyMax=0; }
+  void report(std::ostream& os) const;
+
+  void listen(Signaler& s) { auto lock=listenersMutex(RAI_HERE); listeners.append(&s); listenersN=listeners.N; }
+  void stopListen(Signaler& s) { auto lock=listenersMutex(RAI_HERE); listeners.removeValue(&s); listenersN=listeners.N; }
+
+ private:
+  static int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+  bool popCell(T& msg, int64_t& pushTime);
+  void notify(bool listenersToo);
+  bool wait(const std::function<bool()>& f, double timeout);
+};
+
+template<class T> MessageQueue<T>::MessageQueue(uint capacity, QueuePolicy _policy)
+  : policy(_policy), head(0), tail(0), pushed(0), popped(0), dropped(0), rejected(0), latencySum(0), latencyMax(0), waiting(0), listenersN(0) {
+  uint64_t n=1;
+  while(n<capacity) n<<=1;
+  mask = n-1;
+  cells.reset(new Cell[n]);
+  for(uint64_t i=0; i<n; i++) cells[i].seq=i;
+}
+
+template<class T> bool MessageQueue<T>::tryPush(T& msg) {
+  Cell* c;
+  uint64_t pos = head.load(std::memory_order_relaxed);
+  for(;;) {
+    c = &cells[pos&mask];
+    int64_t d = (int64_t)c->seq.load(std::memory_order_acquire) - (int64_t)pos;
+    if(!d) { if(head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break; }
+    else if(d<0) return false; //full
+    else pos = head.load(std::memory_order_relaxed);
+  }
+  c->msg = std::move(msg);
+  c->pushTime = now();
+  c->seq.store(pos+1, std::memory_order_release);
+  pushed++;
+  return true;
+}
+
+template<class T> bool MessageQueue<T>::popCell(T& msg, int64_t& pushTime) {
+  Cell* c;
+  uint64_t pos = tail.load(std::memory_order_relaxed);
+  for(;;) {
+    c = &cells[pos&mask];
+    int64_t d = (int64_t)c->seq.load(std::memory_order_acquire) - (int64_t)(pos+1);
+    if(!d) { if(tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break; }
+    else if(d<0) return false; //empty
+    else pos = tail.load(std::memory_order_relaxed);
+  }
+  msg = std::move(c->msg);
+  pushTime = c->pushTime;
+  c->seq.store(pos+mask+1, std::memory_order_release);
+  return true;
+}
+
+template<class T> bool MessageQueue<T>::tryPop(T& msg) {
+  int64_t pushTime;
+  if(!popCell(msg, pushTime)) return false;
+  uint64_t latency = now()-pushTime;
+  popped++;
+  latencySum += latency;
+  for(uint64_t m=latencyMax; latency>m && !latencyMax.compare_exchange_weak(m, latency);) {}
+  return true;
+}
+
+template<class T> bool MessageQueue<T>::push(T&& msg, double timeout) {
+  bool good = tryPush(msg);
+  if(!good) {
+    if(policy==QP_dropOldest) {
+      T old;
+      int64_t t;
+      while(!good) {
+        if(popCell(old, t)) dropped++;
+        good = tryPush(msg);
+      }
+    } else if(policy==QP_block) {
+      good = wait([this, &msg]() { return tryPush(msg); }, timeout);
+    }
+    if(!good) { rejected++; return false; }
+  }
+  notify(true);
+  return true;
+}
+
+template<class T> bool MessageQueue<T>::pop(T& msg, double timeout) {
+  bool good = tryPop(msg);
+  if(!good && timeout) good = wait([this, &msg]() { return tryPop(msg); }, timeout);
+  if(good && policy==QP_block) notify(false); //wake blocked producers
+  return good;
+}
+
+template<class T> void MessageQueue<T>::notify(bool listenersToo) {
+  std::atomic_thread_fence(std::memory_order_seq_cst); //the push/pop must be visible before we check for waiters
+  if(waiting) { auto lock = changed.statusMutex(RAI_HERE); changed.broadcast(); }
+  if(listenersToo && listenersN) {
+    auto lock = listenersMutex(RAI_HERE);
+    for(Signaler* s:listeners) s->incrementStatus();
+  }
+}
+
+template<class T> bool MessageQueue<T>::wait(const std::function<bool()>& f, double timeout) {
+  waiting++;
+  bool good;
+  {
+    auto lock = changed.statusMutex(RAI_HERE);
+    if(timeout<0.) { changed.cond.wait(lock, f); good=true; }
+    else good = changed.cond.wait_for(lock, std::chrono::duration<double>(timeout), f);
+  }
+  waiting--;
+  return good;
+}
+
+template<class T> void MessageQueue<T>::report(std::ostream& os) const {
+  os <<"depth=" <<depth() <<'/' <<capacity() <<" pushed=" <<pushed <<" popped=" <<popped <<" dropped=" <<dropped
+     <<" rejected=" <<rejected <<" latency mean=" <<meanLatency() <<"s max=" <<maxLatency() <<'s';
+}
+
+} //namespace rai
+
 // ================================================
 //
 // template definitions
@@ -446,5 +759,48 @@ int Var<T>::waitForRevisionGreaterThan(int rev) {
   return data->getRevision();
 }
 
+template<class T>
+void Var_data<T>::setLockFree(uint maxReaders) {
+  CHECK(!slots, "variable '" <<name <<"' is already lock-free");
+  rwlock.writeLock();
+  Slot* S = new Slot[maxReaders+2]; //the latest and the one being written are never held by the writer and a reader at once
+  for(uint i=0; i<maxReaders+2; i++) S[i].readers=0;
+  S[0].data = data;
+  S[0].revision = revision;
+  S[0].data_time = data_time;
+  latest = 0;
+  slotsN = maxReaders+2;
+  slots.reset(S);
+  publish = [this]() { publishSlot(); };
+  rwlock.unlock();
+}
+
+template<class T>
+typename Var_data<T>::Slot& Var_data<T>::readLatest() {
+  for(;;) {
+    int i = latest;
+    Slot& s = slots[i];
+    s.readers++;
+    if(latest==i) return s; //still the latest after taking the reference: the writer won't touch it
+    s.readers--;
+  }
+}
+
+template<class T>
+void Var_data<T>::publishSlot() {
+  int cur = latest;
+  for(;;) {
+    for(uint i=0; i<slotsN; i++) if((int)i!=cur && !slots[i].readers) {
+      Slot& s = slots[i];
+      s.data = data;
+      s.revision = revision;
+      s.data_time = data_time;
+      latest = i;
+      return;
+    }
+    std::this_thread::yield(); //more than maxReaders tokens are held
+  }
+}
+
 template<class T>
 void Var<T>::stopListening() { thread->event.stopListenTo(data); }
@@ -532,7 +532,6 @@ void timerResume() {
 }
 
 //COPY & PAST from graph.h
-Mutex::TypedToken<rai::Graph> getParameters();
 void initParameters(int _argc, char* _argv[], bool forceReload);
 
 /// memorize the command line arguments and open a log file
@@ -575,6 +574,25 @@ String raiPath(const char* rel) {
   return path;
 }
 
+String cachePath(const char* rel) {
+  String path;
+  const char* env;
+  if((env=getenv("XDG_CACHE_HOME")) && *env) path <<env <<"/rai";
+  else if((env=getenv("HOME")) && *env) path <<env <<"/.cache/rai";
+  else return String();
+  if(rel) path <<"/" <<rel;
+#ifndef RAI_MSVC
+  for(uint i=1; i<=path.N; i++) if(i==path.N || path.p[i]=='/') { //mkdir -p
+      char c=path.p[i];
+      path.p[i]=0;
+      int r=mkdir(path.p, 0755);
+      path.p[i]=c;
+      if(r && errno!=EEXIST) return String();
+    }
+#endif
+  return path;
+}
+
 bool getInteractivity() {
   static int interactivity=-1;
   if(interactivity==-1) interactivity=(checkParameter<bool>("noInteractivity")?0:1);
@@ -62,6 +62,9 @@ template<class T> using ptr=std::shared_ptr<T>;
 using std::make_unique;
 using std::make_shared;
 
+/// copy-on-write access to shared data: if p is shared with others, it is first replaced by a private copy
+template<class T> T& copyOnWrite(ptr<T>& p) { if(p.use_count()>1) p = make_shared<T>(*p); return *p; }
+
 //===========================================================================
 //
 // macros to define the standard <<and >>operatos for most classes
@@ -101,6 +104,7 @@ void system(const char* cmd);
 void open(std::ofstream& fs, const char* name, const char* errmsg="");
 void open(std::ifstream& fs, const char* name, const char* errmsg="");
 String raiPath(const char* rel=nullptr);
+String cachePath(const char* rel=nullptr); ///< $XDG_CACHE_HOME/rai/rel or ~/.cache/rai/rel, created if missing; empty if impossible
 
 //----- very basic ui
 int x11_getKey();
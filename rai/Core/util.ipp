@@ -17,16 +17,41 @@
 #include <sstream>
 #include <string.h>
 #include <iomanip>
+#include <unordered_map>
 #ifndef RAI_MSVC
 #  include <unistd.h>
 #endif
 
 namespace rai {
 
+/// per-thread cache of resolved parameters of type T, valid while the parameter graph revision is unchanged
+template<class T> struct ParameterCache {
+  struct Entry { uint64_t revision; std::string key; bool found; T value; };
+  std::unordered_map<uint64_t, Entry> entries; //key hash -> entry (a hash collision simply overwrites)
+
+  static ParameterCache& get() { static thread_local ParameterCache C; return C; }
+
+  /// returns the entry of key if it is current, otherwise looks key up in the graph and caches the result
+  const Entry& lookup(const char* key) {
+    uint64_t h = checksum_fnv1a(key, strlen(key));
+    auto it = entries.find(h);
+    if(it!=entries.end() && it->second.revision==getParametersRevision() && it->second.key==key) return it->second;
+
+    Entry& e = entries[h];
+    auto P = readParameters();
+    e.revision = getParametersRevision(); //read under lock: any later modification bumps it
+    e.key = key;
+    e.found = P->get<T>(e.value, key);
+    if(e.found) LOG(3) <<std::setw(20) <<key <<" = " <<std::setw(5) <<e.value <<" [" <<typeid(T).name() <<"] (graph)";
+    return e;
+  }
+};
+
 template<class T>
 bool getParameterBase(T& x, const char* key, bool hasDefault, const T* Default) {
-  if(getParameters()->get<T>(x, key)) {
-    LOG(3) <<std::setw(20) <<key <<" = " <<std::setw(5) <<x <<" [" <<typeid(x).name() <<"] (graph)";
+  const typename ParameterCache<T>::Entry& e = ParameterCache<T>::get().lookup(key);
+  if(e.found) {
+    x = e.value;
     return true;
   }
 
@@ -71,11 +96,10 @@ template<class T> bool checkParameter(const char* tag) {
 }
 
 template<class T> void setParameter(const char* key, const T& x){
-  T* y = getParameters()->find<T>(key);
+  auto P = getParameters(); //one token for lookup and write; the revision is bumped when it is released
+  T* y = P->find<T>(key);
   if(y) *y = x;
-  else{
-    getParameters()->newNode<T>(key, {}, x);
-  }
+  else P->newNode<T>(key, {}, x);
 }
 
 }//namespace
@@ -23,8 +23,8 @@ struct ConvexGeometryData {
 };
 }
 
-rai::FclInterface::FclInterface(const rai::Array<ptr<Mesh>>& geometries, double _cutoff)
-  : cutoff(_cutoff) {
+rai::FclInterface::FclInterface(const rai::Array<ptr<Mesh>>& _geometries, double _cutoff)
+  : geometries(_geometries), cutoff(_cutoff) {
   convexGeometryData.resize(geometries.N);
   for(long int i=0; i<geometries.N; i++) {
     if(geometries(i)) {
@@ -72,22 +72,85 @@ void rai::FclInterface::step(const arr& X) {
   CHECK_EQ(X.d0, convexGeometryData.N, "");
   CHECK_EQ(X.d1, 7, "");
 
-  for(auto* obj:objects) {
+  moved.resize(objects.size()) = false;
+  for(uint k=0; k<objects.size(); k++) {
+    fcl::CollisionObject* obj = objects[k];
     uint i = (long int)obj->getUserData();
     if(i<X_lastQuery.d0 && maxDiff(X_lastQuery[i], X[i])<1e-8) continue;
     obj->setTranslation(fcl::Vec3f(X(i, 0), X(i, 1), X(i, 2)));
     obj->setQuatRotation(fcl::Quaternion3f(X(i, 3), X(i, 4), X(i, 5), X(i, 6)));
     obj->computeAABB();
+    moved(k) = true;
   }
-  manager->update();
 
   collisions.clear();
-  manager->collide(this, BroadphaseCallback);
+  if(incremental) {
+    stepIncremental();
+  } else {
+    manager->update();
+    manager->collide(this, BroadphaseCallback);
+  }
   collisions.reshape(collisions.N/2, 2);
 
   X_lastQuery = X;
 }
 
+void rai::FclInterface::stepIncremental() {
+  uint n = objects.size();
+
+  //-- refit the AABBs of moved objects
+  if(aabbs.d0!=n) { aabbs.resize(n, 6); moved = true; }
+  for(uint k=0; k<n; k++) if(moved(k)) {
+      const fcl::AABB& box = objects[k]->getAABB();
+      for(uint j=0; j<3; j++) { aabbs(k, j) = box.min_[j]; aabbs(k, 3+j) = box.max_[j]; }
+    }
+
+  //-- insertion sort of the endpoints along x: linear for the nearly sorted list of a coherent sequence
+  if(sweepList.N!=2*n) sweepList.setStraightPerm(2*n);
+  auto key = [this](uint e) { return aabbs(e/2, 3*(e%2)); };
+  for(uint i=1; i<sweepList.N; i++) {
+    uint e = sweepList(i);
+    double v = key(e);
+    uint j=i;
+    for(; j>0 && key(sweepList(j-1))>v; j--) sweepList(j) = sweepList(j-1);
+    sweepList(j) = e;
+  }
+
+  //-- sweep: candidate pairs overlap along x (by the sweep) and along y and z
+  uintA pairs;
+  uintA active;
+  for(uint e:sweepList) {
+    uint k = e/2;
+    if(e%2) { active.removeValue(k); continue; }
+    for(uint a:active) {
+      if(aabbs(a, 1)>aabbs(k, 4) || aabbs(k, 1)>aabbs(a, 4)) continue;
+      if(aabbs(a, 2)>aabbs(k, 5) || aabbs(k, 2)>aabbs(a, 5)) continue;
+      pairs.append(rai::MIN(a, k));
+      pairs.append(rai::MAX(a, k));
+    }
+    active.append(k);
+  }
+  pairs.reshape(pairs.N/2, 2);
+  std::sort((std::pair<uint, uint>*)pairs.p, (std::pair<uint, uint>*)pairs.p+pairs.d0);
+
+  //-- fine checks; pairs that were candidates before and did not move reuse their last result
+  boolA pairsCollide(pairs.d0);
+  uint l=0;
+  for(uint i=0; i<pairs.d0; i++) {
+    uint a=pairs(i, 0), b=pairs(i, 1);
+    while(l<lastPairs.d0 && (lastPairs(l, 0)<a || (lastPairs(l, 0)==a && lastPairs(l, 1)<b))) l++;
+    if(!moved(a) && !moved(b) && l<lastPairs.d0 && lastPairs(l, 0)==a && lastPairs(l, 1)==b) {
+      pairsCollide(i) = lastPairsCollide(l);
+    } else {
+      pairsCollide(i) = checkPair(objects[a], objects[b]);
+    }
+    if(pairsCollide(i)) addCollision(objects[a]->getUserData(), objects[b]->getUserData());
+  }
+
+  lastPairs = pairs;
+  lastPairsCollide = pairsCollide;
+}
+
 void rai::FclInterface::addCollision(void* userData1, void* userData2) {
   uint a = (long int)userData1;
   uint b = (long int)userData2;
@@ -96,22 +159,24 @@ void rai::FclInterface::addCollision(void* userData1, void* userData2) {
   collisions.elem(-1) = b;
 }
 
-bool rai::FclInterface::BroadphaseCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* cdata_) {
-  rai::FclInterface* self = static_cast<rai::FclInterface*>(cdata_);
-
-  if(self->cutoff==0.) { //fine boolean collision query
+bool rai::FclInterface::checkPair(fcl::CollisionObject* o1, fcl::CollisionObject* o2) {
+  if(cutoff==0.) { //fine boolean collision query
     fcl::CollisionRequest request;
     fcl::CollisionResult result;
     fcl::collide(o1, o2, request, result);
-    if(result.isCollision()) self->addCollision(o1->getUserData(), o2->getUserData());
-  } else if(self->cutoff>0.) { //fine distance query
+    return result.isCollision();
+  } else if(cutoff>0.) { //fine distance query
     fcl::DistanceRequest request;
     fcl::DistanceResult result;
     fcl::distance(o1, o2, request, result);
-    if(result.min_distance<self->cutoff) self->addCollision(o1->getUserData(), o2->getUserData());
-  } else { //just broadphase
-    self->addCollision(o1->getUserData(), o2->getUserData());
+    return result.min_distance<cutoff;
   }
+  return true; //just broadphase
+}
+
+bool rai::FclInterface::BroadphaseCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* cdata_) {
+  rai::FclInterface* self = static_cast<rai::FclInterface*>(cdata_);
+  if(self->checkPair(o1, o2)) self->addCollision(o1->getUserData(), o2->getUserData());
   return false;
 }
 
@@ -19,6 +19,7 @@ class BroadPhaseCollisionManager;
 namespace rai {
 
 struct FclInterface {
+  Array<ptr<Mesh>> geometries; ///< the meshes, whose data the fcl models refer to
   Array<ptr<struct ConvexGeometryData>> convexGeometryData;
   std::vector<fcl::CollisionObject*> objects;
   shared_ptr<fcl::BroadPhaseCollisionManager> manager;
@@ -27,6 +28,14 @@ struct FclInterface {
   uintA collisions; //return values!
   arr X_lastQuery;  //memory to check whether an object has moved in consecutive queries
 
+  //-- in-house incremental broadphase (instead of fcl's manager): sort-and-sweep lists and pair results are kept warm between steps
+  bool incremental=false;
+  arr aabbs;             ///< per object: (lo xyz, up xyz)
+  boolA moved;           ///< per object: whether it moved in the last step
+  uintA sweepList;       ///< endpoints 2*object+isUpper, sorted along x (nearly sorted between consecutive steps)
+  uintA lastPairs;       ///< candidate pairs (object indices, lexicographically sorted) of the last step
+  boolA lastPairsCollide;///< fine result of each candidate pair of the last step
+
   FclInterface(const Array<ptr<Mesh>>& geometries, double _cutoff=0.);
   ~FclInterface();
 
@@ -34,6 +43,8 @@ struct FclInterface {
 
 private: //called by collision callback
   void addCollision(void* userData1, void* userData2);
+  bool checkPair(fcl::CollisionObject* o1, fcl::CollisionObject* o2);
+  void stepIncremental();
   static bool BroadphaseCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* cdata_);
 };
 
@@ -13,6 +13,7 @@
 #include "../Optim/newton.h"
 
 #include <limits>
+#include <unistd.h>
 
 #ifdef RAI_PLY
 #  include "ply/ply.h"
@@ -1380,6 +1381,47 @@ void rai::Mesh::readArr(std::istream& is) {
   texImg.readTagged(is, "texImg");
 }
 
+namespace {
+template<class T> void writeCacheArray(const rai::Array<T>& x, const char* prefix, const char* name) {
+  if(x.N) rai::writeArrayFile(x, STRING(prefix <<name <<".arr"));
+}
+
+template<class T> void readCacheArray(rai::Array<T>& x, const char* prefix, const char* name) {
+  rai::String file = STRING(prefix <<name <<".arr");
+  if(access(file, R_OK)) { x.clear(); return; }
+  rai::Array<T> mapped;
+  std::shared_ptr<rai::MappedFile> handle = rai::mapArrayFile(mapped, file);
+  x = mapped;
+}
+}
+
+void rai::Mesh::writeCache(const char* prefix) const {
+  writeCacheArray(V, prefix, "V");
+  writeCacheArray(Vn, prefix, "Vn");
+  writeCacheArray(C, prefix, "C");
+  writeCacheArray(T, prefix, "T");
+  writeCacheArray(Tn, prefix, "Tn");
+  writeCacheArray(Tt, prefix, "Tt");
+  writeCacheArray(tex, prefix, "tex");
+  writeCacheArray(texImg, prefix, "texImg");
+}
+
+bool rai::Mesh::readCache(const char* prefix) {
+  if(access(STRING(prefix <<"V.arr"), R_OK)) return false;
+  readCacheArray(V, prefix, "V");
+  readCacheArray(Vn, prefix, "Vn");
+  readCacheArray(C, prefix, "C");
+  readCacheArray(T, prefix, "T");
+  readCacheArray(Tn, prefix, "Tn");
+  readCacheArray(Tt, prefix, "Tt");
+  readCacheArray(tex, prefix, "tex");
+  readCacheArray(texImg, prefix, "texImg");
+  graph.clear();
+  ann.reset();
+  _support_vertex=0;
+  return true;
+}
+
 
 //===========================================================================
 // Util
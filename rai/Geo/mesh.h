@@ -128,6 +128,8 @@ struct Mesh : GLDrawer {
   void readPLY(const char* fn);
   void writeArr(std::ostream&);
   void readArr(std::istream&);
+  void writeCache(const char* prefix) const; ///< writes the arrays as binary array files <prefix>V.arr etc.
+  bool readCache(const char* prefix);        ///< maps and copies what writeCache wrote; false if there is none
 
   void glDraw(struct OpenGL&);
 };
@@ -33,6 +33,7 @@
 #include "../Optim/opt-ipopt.h"
 #include "../Optim/opt-ceres.h"
 
+#include "../Core/thread.h"
 #include "../Core/util.ipp"
 
 #include <iomanip>
@@ -107,6 +108,7 @@ void KOMO::clone(const KOMO& komo, bool deepCopyFeatures){
 
   if(komo.fcl) fcl=komo.fcl;
   if(komo.swift) swift=komo.swift;
+  setupFclWorkers(); //not shared: workers keep broadphase state between queries
 
   //directly copy pathConfig instead of recreating it (including switches)
   pathConfig.copy(komo.pathConfig, false);
@@ -756,7 +758,7 @@ void KOMO::reset() {
   featureValues.clear();
   featureJacobians.clear();
   featureTypes.clear();
-  timeTotal=timeCollisions=timeKinematics=timeNewton=timeFeatures=0.;
+  timeTotal=timeCollisions=timeKinematics=timeNewton=timeFeatures=timeFeaturesWall=0.;
 }
 
 //default - transcription as sparse, but non-factored NLP
@@ -764,6 +766,17 @@ struct Conv_KOMO_SparseNonfactored : MathematicalProgram {
   KOMO& komo;
   bool sparse;
 
+  //-- sparsity pattern of J: assembled once on the first evaluation, later evaluations only fill in the values
+  intA jacPattern;       ///< (row,col) of all non-zeros of J, concatenated in objective order
+  uintA jacPatternStart; ///< for each grounded objective the offset of its non-zeros in jacPattern (N==objs.N+1 if valid)
+
+  //-- parallel feature evaluation (KOMO/featureThreads>1)
+  uintAA workerObjs;     ///< for each worker, the grounded objectives (indices into komo.objs) it evaluates
+  rai::Array<Feature*> workerFeats; ///< the feature of each grounded objective when workerObjs was partitioned
+  arrA featureBuffers;   ///< for each grounded objective, the feature (with Jacobian) computed by a worker
+
+  void evaluateFeaturesParallel(uint nThreads);
+
   arr quadraticPotentialLinear, quadraticPotentialHessian;
 
   Conv_KOMO_SparseNonfactored(KOMO& _komo, bool sparse=true);
@@ -912,11 +925,7 @@ void KOMO::run(OptOptions options) {
     timeNewton += _opt.newton.timeNewton;
 
   } else if(solver==rai::KS_banded) {
-    pathConfig.jacMode = rai::Configuration::JM_rowShifted;
-    auto P = make_shared<Conv_KOMO_FactoredNLP>(*this);
-    Conv_FactoredNLP_BandedNLP C(P, 0);
-    C.maxBandSize = (k_order+1)*max(P->variableDimensions);
-    OptConstrained opt(x, dual, C.ptr(), options, logFile);
+    OptConstrained opt(x, dual, mp_Banded(), options, logFile);
     opt.run();
 
   } else if(solver==rai::KS_NLopt) {
@@ -947,7 +956,7 @@ void KOMO::run(OptOptions options) {
   if(logFile)(*logFile) <<"\n] #end of KOMO_run_log" <<endl;
   if(opt.verbose>0) {
     cout <<"** optimization time:" <<timeTotal
-         <<" (kin:" <<timeKinematics <<" coll:" <<timeCollisions <<" feat:" <<timeFeatures <<" newton: " <<timeNewton <<")"
+         <<" (kin:" <<timeKinematics <<" coll:" <<timeCollisions <<" feat:" <<timeFeatures <<" (wall:" <<timeFeaturesWall <<")" <<" newton: " <<timeNewton <<")"
          <<" setJointStateCount:" <<Configuration::setJointStateCount
         <<"\n   sos:" <<sos <<" ineq:" <<ineq <<" eq:" <<eq <<endl;
   }
@@ -1190,6 +1199,11 @@ void KOMO::setupPathConfig() {
     CHECK(!swift, "");
     if(!opt.useFCL) swift = C.swift();
     else fcl = C.fcl();
+
+    if(opt.useFCL) {
+      fcl->incremental = opt.collisionIncremental;
+      setupFclWorkers();
+    }
   }
 
   for(uint s=0;s<k_order+T;s++) {
@@ -1280,7 +1294,11 @@ void KOMO::set_x(const arr& x, const uintA& selectedConfigurationsOnly) {
 
   timeKinematics += rai::cpuTime();
 
-  if(computeCollisions) {
+  if(computeCollisions && fclWorkers.N && opt.useFCL) {
+    timeCollisions -= rai::cpuTime();
+    collideSlicesParallel();
+    timeCollisions += rai::cpuTime();
+  } else if(computeCollisions) {
     timeCollisions -= rai::cpuTime();
     pathConfig.proxies.clear();
     arr X;
@@ -1301,10 +1319,55 @@ void KOMO::set_x(const arr& x, const uintA& selectedConfigurationsOnly) {
   }
 }
 
+/// additional fcl contexts, one per extra worker of set_x (swift is not thread safe), on the same meshes as fcl
+void KOMO::setupFclWorkers() {
+  fclWorkers.clear();
+  if(!fcl || opt.collisionThreads<=1) return;
+  for(int w=1; w<opt.collisionThreads; w++) {
+    fclWorkers.append(make_shared<rai::FclInterface>(fcl->geometries, fcl->cutoff));
+    fclWorkers.last()->incremental = opt.collisionIncremental;
+  }
+}
+
+void KOMO::collideSlicesParallel() {
+  uint S = timeSlices.d0-k_order;
+  uint nThreads = rai::MIN(fclWorkers.N+1, S);
+
+  //frame states are computed serially (forward kinematics is lazy and may cross slices)
+  arrA X(S);
+  for(uint s=0; s<S; s++) X(s) = pathConfig.getFrameState(timeSlices[k_order+s]);
+
+  //each worker queries a contiguous block of slices with its own context (consecutive slices are similar, which keeps fcl's broadphase update cheap)
+  rai::Array<uintA> collisionPairs(S);
+  rai::parallel_for(0, nThreads, [this, &X, &collisionPairs, S, nThreads](uint w) {
+    rai::FclInterface& coll = (w==0 ? *fcl : *fclWorkers(w-1));
+    for(uint s=(w*S)/nThreads; s<((w+1)*S)/nThreads; s++) {
+      coll.step(X(s));
+      collisionPairs(s) = std::move(coll.collisions); //step() clears them anyway
+    }
+  }, 1);
+
+  //proxies are added in slice order, as in the serial loop
+  pathConfig.proxies.clear();
+  for(uint s=0; s<S; s++) {
+    collisionPairs(s) += timeSlices.d1 * (k_order+s);
+    pathConfig.addProxies(collisionPairs(s));
+  }
+  pathConfig._state_proxies_isGood=true;
+}
+
 shared_ptr<MathematicalProgram> KOMO::mp_SparseNonFactored(){
   return make_shared<Conv_KOMO_SparseNonfactored>(*this, solver==rai::KS_sparse);
 }
 
+shared_ptr<MathematicalProgram> KOMO::mp_Banded(){
+  pathConfig.jacMode = rai::Configuration::JM_rowShifted;
+  auto P = make_shared<Conv_KOMO_FactoredNLP>(*this);
+  auto B = make_shared<Conv_FactoredNLP_BandedNLP>(P, 0);
+  B->maxBandSize = (k_order+1)*max(P->variableDimensions);
+  return B;
+}
+
 shared_ptr<MathematicalProgram_Factored> KOMO::mp_Factored(){
   return make_shared<Conv_KOMO_FineStructuredProblem>(*this);
 }
@@ -1523,6 +1586,72 @@ StringA KOMO::getCollisionPairs(double belowMargin){
   return cols;
 }
 
+/// writes a feature's sparse Jacobian values directly into the slots [lo,up) of J -- fails if its non-zeros don't match the pattern
+static bool fillJacobianFromPattern(arr& J, arr& yJ, uint rowOffset, const intA& pattern, uint lo, uint up) {
+  if(yJ.N!=up-lo) return false;
+  if(!yJ.N) return true;
+  const int* e = yJ.sparse().elems.p;
+  const int* p = pattern.p+2*lo;
+  for(uint k=0; k<yJ.N; k++) {
+    if(e[2*k]+(int)rowOffset!=p[2*k] || e[2*k+1]!=p[2*k+1]) return false;
+  }
+  memmove(J.p+lo, yJ.p, yJ.N*yJ.sizeT);
+  return true;
+}
+
+/// partitions the grounded objectives over workers; objectives sharing a Feature object stay on the same worker,
+/// as features may hold state during evaluation (e.g., finite difference order, collision buffers)
+static uintAA partitionObjectives(const rai::Array<ptr<GroundedObjective>>& objs, uint nThreads) {
+  //group objectives by feature
+  rai::Array<Feature*> feats;
+  uintAA groups;
+  for(uint o=0; o<objs.N; o++) {
+    int g = feats.findValue(objs(o)->feat.get());
+    if(g<0) { g=feats.N; feats.append(objs(o)->feat.get()); groups.append(uintA()); }
+    groups(g).append(o);
+  }
+
+  //greedily assign largest groups first to the least loaded worker
+  uintA order;
+  order.setStraightPerm(groups.N);
+  std::stable_sort(order.begin(), order.end(), [&groups](uint a, uint b) { return groups(a).N > groups(b).N; });
+  uintAA workers(nThreads);
+  for(uint g:order) {
+    uint w=0;
+    for(uint i=1; i<nThreads; i++) if(workers(i).N < workers(w).N) w=i;
+    workers(w).append(groups(g));
+  }
+  return workers;
+}
+
+/// resolves all lazily computed state of the path configuration, so that features only read it during concurrent evaluation
+static void prepareConcurrentFeatureEvaluation(rai::Configuration& C) {
+  C.ensure_indexedJoints();
+  C.ensure_q();
+  C.ensure_jointChains();
+  C.ensure_frameNameIndex();
+  for(rai::Frame* f:C.frames) f->ensure_X();
+  for(rai::Proxy& p:C.proxies) if(!p.collision) p.calc_coll();
+}
+
+void Conv_KOMO_SparseNonfactored::evaluateFeaturesParallel(uint nThreads) {
+  prepareConcurrentFeatureEvaluation(komo.pathConfig);
+
+  //repartition whenever the objectives changed (the partition keeps objectives of the same Feature on one worker)
+  rai::Array<Feature*> feats(komo.objs.N);
+  for(uint o=0; o<komo.objs.N; o++) feats(o) = komo.objs(o)->feat.get();
+  if(workerObjs.N!=nThreads || feats!=workerFeats) {
+    workerObjs = partitionObjectives(komo.objs, nThreads);
+    workerFeats = feats;
+  }
+  featureBuffers.resize(komo.objs.N);
+
+  //each task writes only into the buffers of its own objectives
+  rai::parallel_for(0, nThreads, [this](uint w) {
+    for(uint o:workerObjs(w)) featureBuffers(o) = komo.objs(o)->feat->eval(komo.objs(o)->frames);
+  }, 1);
+}
+
 void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
   //-- set the trajectory
   komo.set_x(x);
@@ -1532,25 +1661,58 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
     komo.pathConfig.jacMode = rai::Configuration::JM_dense;
   }
 
+  bool usePattern=false, buildPattern=false;
+  if(!!J && sparse && komo.opt.sparseJacobianPattern) {
+    if(jacPatternStart.N==komo.objs.N+1) usePattern=true;
+    else buildPattern=true;
+  }
+
   phi.resize(featureTypes.N);
   if(!!J) {
     if(sparse) {
-      J.sparse().resize(phi.N, x.N, 0);
+      if(usePattern) {
+        rai::SparseMatrix& S = J.sparse();
+        S.resize(phi.N, x.N, jacPattern.d0);
+        memmove(S.elems.p, jacPattern.p, jacPattern.N*jacPattern.sizeT);
+      } else {
+        J.sparse().resize(phi.N, x.N, 0);
+      }
     } else {
       J.resize(phi.N, x.N).setZero();
     }
   }
+  if(buildPattern) jacPatternStart.resize(komo.objs.N+1);
+
+  //if a feature's Jacobian structure deviates from the pattern: drop the pattern from objective o on and merge as usual
+  auto dropPattern = [&](uint o) {
+    J.sparse().resizeCopy(J.d0, J.d1, jacPatternStart(o));
+    usePattern=false;
+    buildPattern=true;
+  };
 
   komo.sos=komo.ineq=komo.eq=0.;
 
   komo.timeFeatures -= rai::cpuTime();
+  komo.timeFeaturesWall -= rai::realTime();
+
+  //features are computed concurrently, but assembled below in objective order (same result as serial evaluation)
+  uint nThreads = rai::MIN((uint)rai::MAX(komo.opt.featureThreads, 1), komo.objs.N);
+  if(nThreads>1) evaluateFeaturesParallel(nThreads);
 
   uint M=0;
-  for(shared_ptr<GroundedObjective>& ob : komo.objs) {
+  for(uint o=0; o<komo.objs.N; o++) {
+      shared_ptr<GroundedObjective>& ob = komo.objs(o);
+      if(buildPattern) jacPatternStart(o) = J.N;
+
       //query the task map and check dimensionalities of returns
-      arr y = ob->feat->eval(ob->frames);
+      arr y;
+      if(nThreads>1) y = std::move(featureBuffers(o)); //steals value and Jacobian, the buffers are refilled each evaluation
+      else y = ob->feat->eval(ob->frames);
 //      cout <<"EVAL '" <<ob->name() <<"' phi:" <<y <<endl <<y.J() <<endl<<endl;
-      if(!y.N) continue;
+      if(!y.N) {
+        if(usePattern && jacPatternStart(o)!=jacPatternStart(o+1)) dropPattern(o);
+        continue;
+      }
       checkNan(y);
       if(!!J){
         CHECK(y.jac, "Jacobian needed but missing");
@@ -1576,9 +1738,12 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
 
       if(!!J) {
         if(sparse){
-          yJ.sparse().reshape(J.d0, J.d1);
-          yJ.sparse().colShift(M);
-          J += yJ;
+          if(usePattern && !fillJacobianFromPattern(J, yJ, M, jacPattern, jacPatternStart(o), jacPatternStart(o+1))) dropPattern(o);
+          if(!usePattern){
+            yJ.sparse().reshape(J.d0, J.d1);
+            yJ.sparse().colShift(M);
+            J += yJ;
+          }
         }else{
           J.setMatrixBlock(yJ, M, 0);
         }
@@ -1589,6 +1754,13 @@ void Conv_KOMO_SparseNonfactored::evaluate(arr& phi, arr& J, const arr& x) {
   }
 
   komo.timeFeatures += rai::cpuTime();
+  komo.timeFeaturesWall += rai::realTime();
+
+  if(buildPattern) {
+    jacPatternStart.last() = J.N;
+    jacPattern = J.sparse().elems;
+    komo.jacobianPatternBuilds++;
+  }
 
   CHECK_EQ(M, phi.N, "");
   komo.featureValues = phi;
@@ -38,6 +38,10 @@ namespace rai {
     RAI_PARAM("KOMO/", int, animateOptimization, 0)
     RAI_PARAM("KOMO/", bool, mimicStable, false)
     RAI_PARAM("KOMO/", bool, useFCL, true)
+    RAI_PARAM("KOMO/", bool, sparseJacobianPattern, true)
+    RAI_PARAM("KOMO/", int, featureThreads, 1)
+    RAI_PARAM("KOMO/", int, collisionThreads, 1)
+    RAI_PARAM("KOMO/", bool, collisionIncremental, false)
   };
 }//namespace
 
@@ -60,6 +64,7 @@ struct KOMO : NonCopyable {
   bool computeCollisions;         ///< whether swift or fcl (collisions/proxies) is evaluated whenever new configurations are set (needed if features read proxy list)
   shared_ptr<rai::FclInterface> fcl;
   shared_ptr<SwiftInterface> swift;
+  rai::Array<shared_ptr<rai::FclInterface>> fclWorkers; ///< additional fcl contexts for parallel collision queries (KOMO/collisionThreads>1)
 
   //-- optimizer
   rai::KOMOsolver solver=rai::KS_sparse;
@@ -76,6 +81,8 @@ struct KOMO : NonCopyable {
   StringA featureNames;
   double timeTotal=0.;           ///< measured run time
   double timeCollisions=0., timeKinematics=0., timeNewton=0., timeFeatures=0.;
+  double timeFeaturesWall=0.;    ///< wall clock time of feature evaluation (differs from timeFeatures when featureThreads>1)
+  uint jacobianPatternBuilds=0;  ///< how often the sparsity pattern of J was (re)built (KOMO/sparseJacobianPattern)
   ofstream* logFile=0;
 
   KOMO();
@@ -211,6 +218,8 @@ public:
   void retrospectApplySwitches();
   void retrospectChangeJointType(int startStep, int endStep, uint frameID, rai::JointType newJointType);
   void set_x(const arr& x, const uintA& selectedConfigurationsOnly=NoUintA);            ///< set the state trajectory of all configurations
+  void setupFclWorkers();                                                               ///< (re)create the fclWorkers for KOMO/collisionThreads>1 (not shared between clones)
+  void collideSlicesParallel();                                                         ///< collision queries of all slices, distributed over fcl and fclWorkers
 
 
   //===========================================================================
@@ -219,6 +228,7 @@ public:
   //
 
   shared_ptr<MathematicalProgram> mp_SparseNonFactored();
+  shared_ptr<MathematicalProgram> mp_Banded(); ///< RowShifted Jacobians, as solved with KS_banded
   shared_ptr<MathematicalProgram_Factored> mp_Factored();
 
 
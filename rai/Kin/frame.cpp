@@ -13,6 +13,9 @@
 #include "dof_particles.h"
 #include "../Geo/analyticShapes.h"
 #include <climits>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #ifdef RAI_GL
 #include "../Gui/opengl.h"
@@ -47,7 +50,7 @@ void rai::Transformation_Qtoken::operator=(const rai::Transformation& _Q) { f.Q=
 bool rai_Kin_frame_ignoreQuatNormalizationWarning = false;
 
 rai::Frame::Frame(Configuration& _C, const Frame* copyFrame)
-  : C(_C) {
+  : C(_C), Q(*C.allocFramePoses()), X((&Q)[1]) {
 
   ID=C.frames.N;
   C.frames.append(this);
@@ -85,6 +88,8 @@ rai::Frame::~Frame() {
     listReindex(C.frames);
   }
   C.reset_q();
+  C.unindexFrame(this);
+  C.freeFramePoses(&Q);
 }
 
 void rai::Frame::calc_X_from_parent() {
@@ -259,6 +264,7 @@ void rai::Frame::prefixSubtree(const char* prefix) {
   FrameL F = {this};
   getSubtree(F);
   for(auto* f:F) f->name.prepend(prefix);
+  C.reset_frameNameIndex();
 
 }
 
@@ -302,7 +308,7 @@ void rai::Frame::read(const Graph& ats) {
     set_Q()->rot.normalize();
   }
 
-  if(ats["type"]) ats["type"]->key = "shape"; //compatibility with old convention: 'body { type... }' generates shape
+  if(ats["type"]) ats["type"]->setKey("shape"); //compatibility with old convention: 'body { type... }' generates shape
 
   if((n=ats["joint"])) {
     if(ats["B"]) { //there is an extra transform from the joint into this frame -> create an own joint frame
@@ -395,6 +401,13 @@ void rai::Frame::write(std::ostream& os) const {
 
 /************* USER INTERFACE **************/
 
+rai::Frame& rai::Frame::setName(const char* _name) {
+  String oldName = name;
+  name = _name;
+  C.reindexFrameName(this, oldName);
+  return *this;
+}
+
 rai::Frame& rai::Frame::setShape(rai::ShapeType shape, const arr& size) {
   getShape().type() = shape;
   getShape().size() = size;
@@ -452,9 +465,9 @@ rai::Frame& rai::Frame::setPointCloud(const arr& points, const byteA& colors) {
     cerr <<"given point cloud has zero size" <<endl;
     return *this;
   }
-  getShape().mesh().V.clear().operator=(points).reshape(-1, 3);
+  getShape().modifyMesh().V.clear().operator=(points).reshape(-1, 3);
   if(colors.N) {
-    getShape().mesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
+    getShape().modifyMesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
   }
   return *this;
 }
@@ -462,24 +475,24 @@ rai::Frame& rai::Frame::setPointCloud(const arr& points, const byteA& colors) {
 rai::Frame& rai::Frame::setConvexMesh(const arr& points, const byteA& colors, double radius) {
   if(!radius) {
     getShape().type() = ST_mesh;
-    getShape().mesh().V.clear().operator=(points).reshape(-1, 3);
-    getShape().mesh().makeConvexHull();
+    getShape().modifyMesh().V.clear().operator=(points).reshape(-1, 3);
+    getShape().modifyMesh().makeConvexHull();
     getShape().size.clear();
   } else {
     getShape().type() = ST_ssCvx;
-    getShape().sscCore().V.clear().operator=(points).reshape(-1, 3);
-    getShape().sscCore().makeConvexHull();
-    getShape().mesh().setSSCvx(getShape().sscCore().V, radius);
+    getShape().modifySscCore().V.clear().operator=(points).reshape(-1, 3);
+    getShape().modifySscCore().makeConvexHull();
+    getShape().modifyMesh().setSSCvx(getShape().modifySscCore().V, radius);
     getShape().size = ARR(radius);
   }
   if(colors.N) {
-    getShape().mesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
+    getShape().modifyMesh().C.clear().operator=(convert<double>(byteA(colors))/255.).reshape(-1, 3);
   }
   return *this;
 }
 
 rai::Frame& rai::Frame::setColor(const arr& color) {
-  getShape().mesh().C = color;
+  getShape().modifyMesh().C = color;
   return *this;
 }
 
@@ -509,7 +522,7 @@ rai::Frame& rai::Frame::setMass(double mass) {
 
 rai::Frame& rai::Frame::addAttribute(const char* key, double value) {
   if(!ats) ats = make_shared<Graph>();
-  ats->newNode<double>(key, {}, value);
+  copyOnWrite(ats).newNode<double>(key, {}, value);
   return *this;
 }
 
@@ -592,6 +605,7 @@ void rai::Frame::unLink() {
   ensure_X();
   parent->children.removeValue(this);
   parent=nullptr;
+  C.reset_jointChains();
   Q.setZero();
   if(joint) {  delete joint;  joint=nullptr;  }
 }
@@ -613,6 +627,7 @@ rai::Frame& rai::Frame::setParent(rai::Frame* _parent, bool keepAbsolutePose_and
 
   parent=_parent;
   parent->children.append(this);
+  C.reset_jointChains();
 
   if(keepAbsolutePose_and_adaptRelativePose) calc_Q_from_parent();
   _state_updateAfterTouchingQ();
@@ -1247,8 +1262,8 @@ rai::Shape::Shape(Frame& f, const Shape* copyShape)
   frame.shape = this;
   if(copyShape) {
     const Shape& s = *copyShape;
-    if(s._mesh) _mesh = s._mesh; //shallow shared_ptr copy!
-    if(s._sscCore) _sscCore = s._sscCore; //shallow shared_ptr copy!
+    if(s._mesh) _mesh = s._mesh; //shared until modified, see modifyMesh()
+    if(s._sscCore) _sscCore = s._sscCore;
     _type = s._type;
     size = s.size;
     cont = s.cont;
@@ -1261,6 +1276,13 @@ rai::Shape::~Shape() {
   frame.shape = nullptr;
 }
 
+/// the mesh for modification: copies of a Shape share it until then; the collision models, which refer to it, are dropped
+rai::Mesh& rai::Shape::modifyMesh() {
+  mesh();
+  if(cont) frame.C.fclDelete();
+  return copyOnWrite(_mesh);
+}
+
 bool rai::Shape::canCollideWith(const rai::Frame* f) const {
   if(!cont) return false;
   if(!f->shape || !f->shape->cont) return false;
@@ -1272,6 +1294,76 @@ bool rai::Shape::canCollideWith(const rai::Frame* f) const {
   return true;
 }
 
+/// the mesh cache entry for these attributes: a hash of all attributes that determine the meshes and of the content
+/// of the referred files (so that any change of a source invalidates it); empty if there is no mesh file or caching is off
+rai::String rai::Shape::meshCachePath(const Graph& ats) {
+  static bool useCache = rai::getParameter<bool>("Kin/meshCache", true);
+  Node* n;
+  if(!useCache || !(n=ats["mesh"])) return String();
+  String key("v1"); //increment when the mesh processing changes
+  for(const char* a: {"shape", "type", "size", "mesh", "meshscale", "color", "texture", "coloredBox", "mesh_rope"})
+    if((n=ats[a])) key <<' ' <<*n;
+  for(const char* a: {"mesh", "texture"}) if((n=ats[a])) {
+      if(n->isOfType<String>()) key <<' ' <<checksum_file(n->get<String>());
+      else if(n->isOfType<FileToken>()) key <<' ' <<checksum_file(n->get<FileToken>().absolutePathName());
+    }
+  String path = cachePath("meshes");
+  if(path.N) path <<'/' <<checksum_fnv1a(key.p, key.N);
+  return path;
+}
+
+/// removes a (partial or corrupt) cache entry directory
+static void removeMeshCacheEntry(const char* path) {
+  DIR* dir = opendir(path);
+  if(dir) {
+    for(dirent* e; (e=readdir(dir));) if(e->d_name[0]!='.') unlink(STRING(path <<'/' <<e->d_name));
+    closedir(dir);
+  }
+  rmdir(path);
+}
+
+/// returns false (and removes the entry) if the entry is missing or corrupt -- the caller then loads the meshes normally
+bool rai::Shape::readMeshCache(const char* path) {
+  if(access(STRING(path <<"/info.arr"), R_OK)) return false;
+  ShapeType type0=type();
+  arr size0=size;
+  try {
+    arr info;
+    if(!mesh().readCache(STRING(path <<"/mesh_"))) HALT("no mesh in entry");
+    std::shared_ptr<MappedFile> handle = mapArrayFile(info, STRING(path <<"/info.arr"));
+    CHECK_GE(info.N, 1, "");
+    type() = (ShapeType)(int)info(0);
+    size = info({1, -1});
+    if(!sscCore().readCache(STRING(path <<"/core_"))) _sscCore.reset();
+  } catch(const std::exception& e) {
+    LOG(-1) <<"removing corrupt mesh cache entry '" <<path <<"': " <<e.what();
+    removeMeshCacheEntry(path);
+    _mesh.reset();
+    _sscCore.reset();
+    type()=type0;
+    size=size0;
+    return false;
+  }
+  return true;
+}
+
+/// writes the entry into a temporary directory which is then renamed, so that concurrent processes never see partial entries;
+/// failures (full disk, read-only cache) only cost the caching
+void rai::Shape::writeMeshCache(const char* path) {
+  String tmp = STRING(path <<".tmp" <<getpid());
+  if(mkdir(tmp, 0755)) { LOG(-1) <<"could not create mesh cache entry '" <<tmp <<"'"; return; }
+  try {
+    mesh().writeCache(STRING(tmp <<"/mesh_"));
+    if(_sscCore) _sscCore->writeCache(STRING(tmp <<"/core_"));
+    writeArrayFile(cat({(double)type()}, size), STRING(tmp <<"/info.arr"));
+  } catch(const std::exception& e) {
+    LOG(-1) <<"could not write mesh cache entry '" <<path <<"': " <<e.what();
+    removeMeshCacheEntry(tmp);
+    return;
+  }
+  if(rename(tmp, path)) removeMeshCacheEntry(tmp); //another process was faster
+}
+
 void rai::Shape::read(const Graph& ats) {
 
   {
@@ -1285,49 +1377,53 @@ void rai::Shape::read(const Graph& ats) {
     else if(ats.get(str, "shape")) { str>> type(); }
     else if(ats.get(d, "type"))    { type()=(ShapeType)(int)d;}
     else if(ats.get(str, "type"))  { str>> type(); }
-    if(ats.get(str, "mesh"))     { mesh().read(FILE(str), str.getLastN(3).p, str); }
-    else if(ats.get(fil, "mesh"))     {
-      fil.cd_file();
-      mesh().read(fil.getIs(), fil.name.getLastN(3).p, fil.name);
+    String cache = meshCachePath(ats);
+    if(!cache.N || !readMeshCache(cache)) {
+      if(ats.get(str, "mesh"))     { mesh().read(FILE(str), str.getLastN(3).p, str); }
+      else if(ats.get(fil, "mesh"))     {
+        fil.cd_file();
+        mesh().read(fil.getIs(), fil.name.getLastN(3).p, fil.name);
 //      cout <<"MESH: " <<mesh().V.dim() <<endl;
-    }
-    if(ats.get(fil, "texture"))     {
-      fil.cd_file();
-      read_ppm(mesh().texImg, fil.name, true);
+      }
+      if(ats.get(fil, "texture"))     {
+        fil.cd_file();
+        read_ppm(mesh().texImg, fil.name, true);
 //      cout <<"TEXTURE: " <<mesh().texImg.dim() <<endl;
-    }
-    if(ats.get(d, "meshscale"))  { mesh().scale(d); }
-    if(ats.get(x, "meshscale"))  { mesh().scale(x(0), x(1), x(2)); }
-    if(ats.get(mesh().C, "color")) {
-      CHECK(mesh().C.N==3 || mesh().C.N==4, "color needs to be 3D or 4D (floats)");
-    }
-    if(ats.get(x, "mesh_rope"))  {
-      CHECK_EQ(x.N, 4, "requires 3D extend and numSegments");
-      uint n=x(-1);
-      arr y = x({0,2});
-      arr& V = mesh().V;
-      V.resize(n+1, 3).setZero();
-      for(uint i=1;i<=n;i++){
-        V[i] = (double(i)/n)*y;
       }
-      mesh().makeLineStrip();
-    }
+      if(ats.get(d, "meshscale"))  { mesh().scale(d); }
+      if(ats.get(x, "meshscale"))  { mesh().scale(x(0), x(1), x(2)); }
+      if(ats.get(mesh().C, "color")) {
+        CHECK(mesh().C.N==3 || mesh().C.N==4, "color needs to be 3D or 4D (floats)");
+      }
+      if(ats.get(x, "mesh_rope"))  {
+        CHECK_EQ(x.N, 4, "requires 3D extend and numSegments");
+        uint n=x(-1);
+        arr y = x({0,2});
+        arr& V = mesh().V;
+        V.resize(n+1, 3).setZero();
+        for(uint i=1;i<=n;i++){
+          V[i] = (double(i)/n)*y;
+        }
+        mesh().makeLineStrip();
+      }
 
-    if(mesh().V.N && type()==ST_none) type()=ST_mesh;
-
-    //colored box?
-    if(ats["coloredBox"]) {
-      CHECK_EQ(mesh().V.d0, 8, "I need a box");
-      arr col=mesh().C;
-      mesh().C.resize(mesh().T.d0, 3);
-      for(uint i=0; i<mesh().C.d0; i++) {
-        if(i==2 || i==3) mesh().C[i] = col; //arr(color, 3);
-        else if(i>=4 && i<=7) mesh().C[i] = 1.;
-        else mesh().C[i] = .5;
+      if(mesh().V.N && type()==ST_none) type()=ST_mesh;
+
+      //colored box?
+      if(ats["coloredBox"]) {
+        CHECK_EQ(mesh().V.d0, 8, "I need a box");
+        arr col=mesh().C;
+        mesh().C.resize(mesh().T.d0, 3);
+        for(uint i=0; i<mesh().C.d0; i++) {
+          if(i==2 || i==3) mesh().C[i] = col; //arr(color, 3);
+          else if(i>=4 && i<=7) mesh().C[i] = 1.;
+          else mesh().C[i] = .5;
+        }
       }
-    }
 
-    createMeshes();
+      createMeshes();
+      if(cache.N) writeMeshCache(cache);
+    }
   }
 
   if(ats["contact"]) {
@@ -1440,6 +1536,8 @@ void rai::Shape::glDraw(OpenGL& gl) {
 }
 
 void rai::Shape::createMeshes() {
+  if(_mesh) copyOnWrite(_mesh);
+  if(_sscCore) copyOnWrite(_sscCore);
   //create mesh for basic shapes
   switch(_type) {
     case rai::ST_none: HALT("shapes should have a type - somehow wrong initialization..."); break;
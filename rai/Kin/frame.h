@@ -72,13 +72,13 @@ struct Transformation_Qtoken {
 struct Frame : NonCopyable {
   Configuration& C;        ///< a Frame is uniquely associated with a Configuration
   uint ID;                 ///< unique identifier (index in Configuration.frames)
-  String name;             ///< name
+  String name;             ///< name -- to rename a frame that may have been looked up already, use setName()
   Frame* parent=nullptr;   ///< parent frame
   FrameL children;         ///< list of children
 
  protected:
-  Transformation Q=0;        ///< relative transform to parent
-  Transformation X=0;        ///< frame's absolute pose
+  Transformation& Q;         ///< relative transform to parent (stored in the Configuration's pose pool)
+  Transformation& X;         ///< frame's absolute pose (stored right after Q)
   //data structure state (lazy evaluation leave the state structure out of sync)
   bool _state_X_isGood=true; // X represents the current state
   void _state_setXBadinBranch();
@@ -141,6 +141,7 @@ struct Frame : NonCopyable {
   void write(std::ostream& os) const;
 
   //-- HIGHER LEVEL USER INTERFACE
+  Frame& setName(const char* _name);
   Frame& setShape(rai::ShapeType shape, const arr& size);
   Frame& setPose(const rai::Transformation& _X);
   Frame& setPosition(const arr& pos);
@@ -291,6 +292,8 @@ struct Shape : NonCopyable, GLDrawer {
   Enum<ShapeType>& type() { return _type; }
   Mesh& mesh() { if(!_mesh) _mesh = make_shared<Mesh>();  return *_mesh; }
   Mesh& sscCore() { if(!_sscCore) _sscCore = make_shared<Mesh>();  return *_sscCore; }
+  Mesh& modifyMesh();
+  Mesh& modifySscCore() { sscCore();  return copyOnWrite(_sscCore); }
   double alpha() { arr& C=mesh().C; if(C.N==4) return C(3); return 1.; }
 
   void createMeshes();
@@ -305,6 +308,11 @@ struct Shape : NonCopyable, GLDrawer {
   void write(std::ostream& os) const;
   void write(Graph& g);
   void glDraw(OpenGL&);
+
+  //-- binary cache of meshes loaded from files (~/.cache/rai/meshes, disable with the parameter Kin/meshCache)
+  static String meshCachePath(const Graph& ats);
+  bool readMeshCache(const char* path);
+  void writeMeshCache(const char* path);
 };
 
 //===========================================================================
@@ -19,6 +19,7 @@
 #include "featureSymbols.h"
 #include "viewer.h"
 #include "../Core/graph.h"
+#include "../Core/thread.h"
 #include "../Geo/fclInterface.h"
 #include "../Geo/qhull.h"
 #include "../Geo/mesh_readAssimp.h"
@@ -29,6 +30,7 @@
 #include <algorithm>
 #include <sstream>
 #include <climits>
+#include <unordered_map>
 
 #ifdef RAI_ASSIMP
 #  include <assimp/Exporter.hpp>
@@ -79,7 +81,7 @@ uintA jointsToIndices(const JointL& joints) {
 
 void makeConvexHulls(FrameL& frames, bool onlyContactShapes) {
   for(Frame* f: frames) if(f->shape && (!onlyContactShapes || f->shape->cont))
-      f->shape->mesh().makeConvexHull();
+      f->shape->modifyMesh().makeConvexHull();
 }
 
 void computeOptimalSSBoxes(FrameL& frames) {
@@ -121,7 +123,111 @@ void computeMeshGraphs(FrameL& frames, bool force) {
 // Configuration
 //
 
+/// name -> frames lookup for getFrame; frames are indexed lazily as they are appended; renames need to go through
+/// Frame::setName (or reset_frameNameIndex), otherwise a renamed frame is only found if no indexed frame carries its name
+struct FrameNameIndex {
+  std::unordered_map<uint64_t, FrameL> buckets; //name hash -> frames with that name, in ID order (e.g., over time slices)
+  std::atomic<uint> indexedN{0}; //frames with ID<indexedN are indexed; once all are, lookups only read and need no lock
+  std::mutex mx;                 //guards indexing new frames (getFrame is const and indexes lazily)
+
+  static uint64_t hash(const char* name, uint n) { return checksum_fnv1a(name, n); }
+  void clear() { buckets.clear(); indexedN=0; }
+  void insert(Frame* f) {
+    FrameL& B = buckets[hash(f->name.p, f->name.N)];
+    uint i=B.N;
+    while(i && B.elem(i-1)->ID>f->ID) i--;
+    if(i && B.elem(i-1)==f) return;
+    B.insert(i, f);
+  }
+  void update(const FrameL& frames) {
+    if(indexedN>frames.N) clear();
+    uint n=indexedN;
+    for(; n<frames.N; n++) insert(frames.elem(n));
+    indexedN=n; //published only when complete
+  }
+  void remove(Frame* f) { //f is already removed from the frames list; the others keep their relative order
+    if(f->ID>=indexedN) return;
+    auto it = buckets.find(hash(f->name.p, f->name.N));
+    if(it==buckets.end() || !it->second.contains(f)) { clear(); return; } //renamed without setName
+    it->second.removeValue(f);
+    if(!it->second.N) buckets.erase(it);
+    indexedN--;
+  }
+  void rename(Frame* f, const char* oldName) {
+    if(f->ID>=indexedN) return; //indexed later anyway
+    auto it = buckets.find(hash(oldName, strlen(oldName)));
+    if(it!=buckets.end()) it->second.removeValue(f, false);
+    insert(f);
+  }
+};
+
+/// an active ancestor joint of a frame, precompiled for Jacobian assembly
+struct JointChainLink {
+  Joint* joint;
+  Frame* frame;     //the joint's frame
+  uint qIndex;
+  JointType type;
+  double scale;
+  bool isRoot;      //the frame has no parent (jacobian_pos ignores such joints)
+};
+
+/// the chains of active ancestor joints of all frames, in one contiguous buffer; built for all frames at once by the
+/// first Jacobian (under a lock, so concurrent Jacobians are safe), only read afterwards, and dropped whenever the joint
+/// indexing or the tree changes
+struct JointChains {
+  std::vector<JointChainLink> links;
+  std::vector<std::pair<uint, uint>> ranges; //per frame ID: [begin, end) in links
+  std::atomic<bool> complete{false};         //the chains of all frames are built
+  std::mutex mx;
+
+  void clear() { links.clear(); ranges.clear(); complete=false; }
+
+  void ensure(const FrameL& frames, uint N) {
+    if(complete && ranges.size()==frames.N) return;
+    std::lock_guard<std::mutex> lock(mx);
+    if(complete && ranges.size()==frames.N) return;
+    links.clear();
+    ranges.resize(frames.N);
+    for(Frame* a: frames) {
+      std::pair<uint, uint>& r = ranges[a->ID];
+      r.first = links.size();
+      for(Frame* f=a; f; f=f->parent) {
+        Joint* j=f->joint;
+        if(!j || !j->active) continue;
+        if(j->qIndex>=N) { CHECK_EQ(j->type, JT_rigid, ""); continue; }
+        links.push_back({j, f, j->qIndex, j->type, j->scale, !f->parent});
+      }
+      r.second = links.size();
+    }
+    complete=true;
+  }
+};
+
+/// the poses (Q and X) of all frames, in chunks of contiguous storage that never move; freed slots are reused
+struct PosePool {
+  static const uint chunkSize=256; //frames per chunk
+  std::vector<std::unique_ptr<Transformation[]>> chunks;
+  std::vector<Transformation*> freed;
+  uint used=0; //frames allocated from the last chunk
+
+  Transformation* alloc() {
+    Transformation* QX;
+    if(freed.size()) { QX=freed.back(); freed.pop_back(); }
+    else {
+      if(!chunks.size() || used==chunkSize) { chunks.emplace_back(new Transformation[2*chunkSize]); used=0; }
+      QX = chunks.back().get() + 2*used++;
+    }
+    QX[0].setZero();
+    QX[1].setZero();
+    return QX;
+  }
+  void free(Transformation* QX) { freed.push_back(QX); }
+};
+
 struct sConfiguration {
+  PosePool poses;
+  FrameNameIndex frameNames;
+  JointChains jointChains;
   shared_ptr<ConfigurationViewer> viewer;
   shared_ptr<SwiftInterface> swift;
   shared_ptr<FclInterface> fcl;
@@ -143,7 +249,8 @@ Configuration::~Configuration() {
   self.reset();
 }
 
-/// make this a copy of C (copying all frames, forces & proxies)
+/// make this a copy of C (copying all frames, forces & proxies); shape meshes and frame attributes are shared
+/// with C until either side modifies them (Shape::modifyMesh(), copyOnWrite())
 void Configuration::copy(const Configuration& C, bool referenceSwiftOnCopy) {
   CHECK(this != &C, "never copy C onto itself");
 
@@ -352,13 +459,28 @@ void Configuration::addConfiguration(const Configuration& C, double tau){
   if(tau>=0.) f->tau=tau;
 }
 
-/// get first frame with given name
+/// get first frame with given name (const, but indexes new frames first)
 Frame* Configuration::getFrame(const char* name, bool warnIfNotExist, bool reverse) const {
+  ensure_frameNameIndex();
+  FrameNameIndex& I = self->frameNames;
+  auto it = I.buckets.find(FrameNameIndex::hash(name, strlen(name)));
+  if(it!=I.buckets.end()) {
+    const FrameL& B = it->second;
+    if(!reverse) {
+      for(Frame* b: B) if(b->name==name) return b;
+    } else {
+      for(uint i=B.N; i--;) if(B.elem(i)->name==name) return B.elem(i);
+    }
+  }
+
+  //not in the index -- but it might have been renamed without setName
+  Frame* f=0;
   if(!reverse) {
-    for(Frame* b: frames) if(b->name==name) return b;
+    for(Frame* b: frames) if(b->name==name) { f=b; break; }
   } else {
-    for(uint i=frames.N; i--;) if(frames.elem(i)->name==name) return frames.elem(i);
+    for(uint i=frames.N; i--;) if(frames.elem(i)->name==name) { f=frames.elem(i); break; }
   }
+  if(f) return f;
   if(warnIfNotExist) RAI_MSG("cannot find frame named '" <<name <<"'");
   return 0;
 }
@@ -535,13 +657,22 @@ arr Configuration::getDofState(const DofL& dofs) const {
 
 /// get the (F.N,7)-matrix of all poses for all given frames
 arr Configuration::getFrameState(const FrameL& F) const {
-  arr X(F.N, 7);
-  for(uint i=0; i<X.d0; i++) {
-    X[i] = F.elem(i)->ensure_X().getArr7d();
-  }
+  arr X;
+  getFrameState(X, F);
   return X;
 }
 
+void Configuration::getFrameState(arr& X, const FrameL& F) const {
+  if(X.nd!=2 || X.d0!=F.N || X.d1!=7) X.resize(F.N, 7);
+  double* x=X.p;
+  for(Frame* f:F) {
+    const Transformation& T = f->ensure_X();
+    x[0]=T.pos.x;  x[1]=T.pos.y;  x[2]=T.pos.z;
+    x[3]=T.rot.w;  x[4]=T.rot.x;  x[5]=T.rot.y;  x[6]=T.rot.z;
+    x+=7;
+  }
+}
+
 /// set the q-vector (all joint and force DOFs)
 void Configuration::setJointState(const arr& _q) {
   setJointStateCount++; //global counter
@@ -608,10 +739,11 @@ void Configuration::setDofState(const arr& _q, const DofL& dofs) {
 /// set the pose of all frames as given by the (F.N,7)-matrix
 void Configuration::setFrameState(const arr& X, const FrameL& F) {
   CHECK_EQ(X.d0, F.N, "X.d0=" <<X.d0 <<" is larger than frames.N=" <<F.N);
+  CHECK_EQ(X.d1, 7, "frame states need to be 7D poses");
   for(Frame* f:F) f->_state_setXBadinBranch();
   for(uint i=0; i<F.N; i++) {
     Frame *f = F.elem(i);
-    f->X.set(X[i]);
+    f->X.set(X.p+7*i);
     f->X.rot.normalize();
     f->_state_X_isGood = true;
   }
@@ -906,6 +1038,45 @@ void Configuration::reset_q() {
 
   _state_indexedJoints_areGood=false;
   _state_q_isGood=false;
+  self->jointChains.clear();
+}
+
+void Configuration::reset_frameNameIndex() {
+  std::lock_guard<std::mutex> lock(self->frameNames.mx);
+  self->frameNames.clear();
+}
+
+void Configuration::reindexFrameName(Frame* f, const char* oldName) {
+  std::lock_guard<std::mutex> lock(self->frameNames.mx);
+  self->frameNames.rename(f, oldName);
+}
+
+void Configuration::unindexFrame(Frame* f) {
+  std::lock_guard<std::mutex> lock(self->frameNames.mx);
+  self->frameNames.remove(f);
+}
+
+void Configuration::ensure_frameNameIndex() const {
+  FrameNameIndex& I = self->frameNames;
+  if(I.indexedN==frames.N) return;
+  std::lock_guard<std::mutex> lock(I.mx);
+  I.update(frames);
+}
+
+void Configuration::reset_jointChains() {
+  self->jointChains.clear();
+}
+
+Transformation* Configuration::allocFramePoses() {
+  return self->poses.alloc();
+}
+
+void Configuration::freeFramePoses(Transformation* QX) {
+  self->poses.free(QX);
+}
+
+void Configuration::ensure_jointChains() const {
+  self->jointChains.ensure(frames, getJointStateDimension());
 }
 
 /** @brief re-orient all joints (edges) such that n becomes
@@ -1012,6 +1183,8 @@ void Configuration::sortFrames() {
   frames = calc_topSort();
   uint i=0;
   for(Frame* f: frames) f->ID = i++;
+  reset_frameNameIndex();
+  reset_jointChains();
 }
 
 void Configuration::makeObjectsFree(const StringA& objects, double H_cost) {
@@ -1276,6 +1449,7 @@ FrameL Configuration::getCollisionAllPairs(){
 void Configuration::prefixNames(bool clear) {
   if(!clear) for(Frame* a: frames) a->name=STRING('_' <<a->ID <<'_' <<a->name);
   else       for(Frame* a: frames) a->name.clear() <<a->ID;
+  reset_frameNameIndex();
 }
 
 void Configuration::calc_indexedActiveJoints(bool resetActiveJointSet) {
@@ -1303,6 +1477,7 @@ void Configuration::calc_indexedActiveJoints(bool resetActiveJointSet) {
   }
 
   _state_indexedJoints_areGood=true;
+  self->jointChains.clear(); //the qIndices change
 
   //-- count active DOFs
   uint qcount=0;
@@ -1503,6 +1678,111 @@ void Configuration::kinematicsZero(arr& y, arr& J, uint n) const {
   jacobian_zero(J, n);
 }
 
+/// J(:,col) += scale*v
+static inline void addColumn(arr& J, uint col, const Vector& v, double scale) {
+  J.elem(0, col) += scale*v.x;
+  J.elem(1, col) += scale*v.y;
+  J.elem(2, col) += scale*v.z;
+}
+
+/// column i of R
+static inline Vector column(const Matrix& R, uint i) {
+  const double* m=&R.m00;
+  return Vector(m[i], m[3+i], m[6+i]);
+}
+
+/// column i of Quaternion::getJacobian(), without arr temporaries
+static inline Vector quatJacobianColumn(const Quaternion& rot, uint i) {
+  Quaternion e(i==0, i==1, i==2, i==3);
+  e = e / rot;
+  return Vector(-2.*e.x, -2.*e.y, -2.*e.z);
+}
+
+/// adds to J (3 x n) the columns of one joint for the linear velocity of the world point pos_world; 'from' is the world pose
+/// of the joint's parent, Q its relative pose and qj its (unscaled) dofs
+static void addJointJacobian_pos(arr& J, JointType type, uint j_idx, double scale, const Vector& axis,
+                                 const Transformation& from, const Transformation& Q, const double* qj, const Vector& pos_world) {
+  switch(type) {
+    case JT_transXYZ:
+      J.elem(0, j_idx) += scale;
+      J.elem(1, j_idx+1) += scale;
+      J.elem(2, j_idx+2) += scale;
+      break;
+    case JT_hingeX: case JT_hingeY: case JT_hingeZ:
+      addColumn(J, j_idx, axis ^ (pos_world-from*Q.pos), scale);
+      break;
+    case JT_transX: case JT_transY: case JT_transZ:
+      addColumn(J, j_idx, axis, scale);
+      break;
+    case JT_transXY: {
+      Matrix R = from.rot.getMatrix();
+      addColumn(J, j_idx, column(R, 0), scale);
+      addColumn(J, j_idx+1, column(R, 1), scale);
+    } break;
+    case JT_transXYPhi: {
+      Matrix R = from.rot.getMatrix();
+      addColumn(J, j_idx, column(R, 0), scale);
+      addColumn(J, j_idx+1, column(R, 1), scale);
+      addColumn(J, j_idx+2, axis ^ (pos_world-(from.pos + from.rot*Q.pos)), scale);
+    } break;
+    case JT_phiTransXY: {
+      addColumn(J, j_idx, axis ^ (pos_world-from.pos), scale);
+      Matrix R = (from.rot*Q.rot).getMatrix();
+      addColumn(J, j_idx+1, column(R, 0), scale);
+      addColumn(J, j_idx+2, column(R, 1), scale);
+    } break;
+    case JT_trans3: {
+      Matrix R = from.rot.getMatrix();
+      for(uint i=0; i<3; i++) addColumn(J, j_idx+i, column(R, i), scale);
+    } break;
+    default: break;
+  }
+  if(type==JT_XBall) {
+    addColumn(J, j_idx, from.rot.getX(), scale);
+  }
+  if(type==JT_free) {
+    Matrix R = from.rot.getMatrix();
+    for(uint i=0; i<3; i++) addColumn(J, j_idx+i, column(R, i), scale);
+  }
+  if(type==JT_quatBall || type==JT_free || type==JT_XBall) {
+    uint offset = 0;
+    if(type==JT_XBall) offset=1;
+    if(type==JT_free) offset=3;
+    Matrix R = from.rot.getMatrix(); //transform w-vectors into world coordinate
+    Vector lever = pos_world-(from.pos+from.rot*Q.pos);
+    qj += offset;
+    double norm = sqrt(qj[0]*qj[0]+qj[1]*qj[1]+qj[2]*qj[2]+qj[3]*qj[3]); //account for the potential non-normalization of q
+    for(uint i=0; i<4; i++) {
+      Vector w = (R*quatJacobianColumn(Q.rot, i)) ^ lever; //cross-product of the w-vector with lever
+      w /= norm;
+      addColumn(J, j_idx+offset+i, w, scale);
+    }
+  }
+}
+
+/// adds to J (3 x n) the columns of one joint for the angular velocity of its descendants (arguments as above)
+static void addJointJacobian_angular(arr& J, JointType type, uint j_idx, double scale, const Vector& axis,
+                                     const Transformation& from, const Transformation& Q, const double* qj) {
+  if((type>=JT_hingeX && type<=JT_hingeZ) || type==JT_transXYPhi || type==JT_phiTransXY) {
+    if(type==JT_transXYPhi) j_idx += 2; //refer to the phi only
+    addColumn(J, j_idx, axis, scale);
+  }
+  if(type==JT_quatBall || type==JT_free || type==JT_XBall) {
+    uint offset = 0;
+    if(type==JT_XBall) offset=1;
+    if(type==JT_free) offset=3;
+    Matrix R = from.rot.getMatrix(); //transform w-vectors into world coordinate
+    qj += offset;
+    double norm = sqrt(qj[0]*qj[0]+qj[1]*qj[1]+qj[2]*qj[2]+qj[3]*qj[3]); //account for the potential non-normalization of q
+    for(uint i=0; i<4; i++) {
+      Vector w = R*quatJacobianColumn(Q.rot, i);
+      w /= norm;
+      addColumn(J, j_idx+offset+i, w, scale);
+    }
+  }
+  //all other joints: J=0 !!
+}
+
 /// what is the linear velocity of a world point (pos_world) attached to frame a for a given joint velocity?
 void Configuration::jacobian_pos(arr& J, Frame* a, const Vector& pos_world) const {
   CHECK_EQ(&a->C, this, "");
@@ -1513,83 +1793,12 @@ void Configuration::jacobian_pos(arr& J, Frame* a, const Vector& pos_world) cons
   jacobian_zero(J, 3);
   if(!J) return;
 
-  while(a) { //loop backward down the kinematic tree
-    if(!a->parent) break; //frame has no inlink -> done
-    Joint* j=a->joint;
-    if(j && j->active) {
-      uint j_idx=j->qIndex;
-      if(j_idx>=N) if(j->active) CHECK_EQ(j->type, JT_rigid, "");
-      if(j_idx<N) {
-        if (j->type == JT_transXYZ) {
-          // Assuming JT_transXYZ has 3 DoF, one for each axis
-          J.elem(0, j_idx) += j->scale * 1.0;   // Update for X-axis
-          J.elem(1, j_idx + 1) += j->scale * 1.0; // Update for Y-axis
-          J.elem(2, j_idx + 2) += j->scale * 1.0; // Update for Z-axis
-        }
-        if(j->type==JT_hingeX || j->type==JT_hingeY || j->type==JT_hingeZ) {
-          Vector tmp = j->axis ^ (pos_world-j->X()*j->Q().pos);
-          tmp *= j->scale;
-          J.elem(0, j_idx) += tmp.x;
-          J.elem(1, j_idx) += tmp.y;
-          J.elem(2, j_idx) += tmp.z;
-        } else if(j->type==JT_transX || j->type==JT_transY || j->type==JT_transZ || j->type==JT_XBall) {
-          J.elem(0, j_idx) += j->scale * j->axis.x;
-          J.elem(1, j_idx) += j->scale * j->axis.y;
-          J.elem(2, j_idx) += j->scale * j->axis.z;
-        } else if(j->type==JT_transXY) {
-          arr R = j->X().rot.getArr();
-          R *= j->scale;
-          J.setMatrixBlock(R.sub(0, -1, 0, 1), 0, j_idx);
-        } else if(j->type==JT_transXYPhi) {
-          arr R = j->X().rot.getArr();
-          R *= j->scale;
-          J.setMatrixBlock(R.sub(0, -1, 0, 1), 0, j_idx);
-          Vector tmp = j->axis ^ (pos_world-(j->X().pos + j->X().rot*a->Q.pos));
-          tmp *= j->scale;
-          J.elem(0, j_idx+2) += tmp.x;
-          J.elem(1, j_idx+2) += tmp.y;
-          J.elem(2, j_idx+2) += tmp.z;
-        } else if(j->type==JT_phiTransXY) {
-          Vector tmp = j->axis ^ (pos_world-j->X().pos);
-          tmp *= j->scale;
-          J.elem(0, j_idx) += tmp.x;
-          J.elem(1, j_idx) += tmp.y;
-          J.elem(2, j_idx) += tmp.z;
-          arr R = (j->X().rot*a->Q.rot).getArr();
-          R *= j->scale;
-          J.setMatrixBlock(R.sub(0, -1, 0, 1), 0, j_idx+1);
-        }
-        if(j->type==JT_XBall) {
-          arr R = conv_vec2arr(j->X().rot.getX());
-          R *= j->scale;
-          R.reshape(3, 1);
-          J.setMatrixBlock(R, 0, j_idx);
-        }
-        if(j->type==JT_trans3 || j->type==JT_free) {
-          arr R = j->X().rot.getArr();
-          R *= j->scale;
-          J.setMatrixBlock(R, 0, j_idx);
-        }
-        if(j->type==JT_quatBall || j->type==JT_free || j->type==JT_XBall) {
-          uint offset = 0;
-          if(j->type==JT_XBall) offset=1;
-          if(j->type==JT_free) offset=3;
-          arr Jrot = j->X().rot.getArr() * a->Q.rot.getJacobian(); //transform w-vectors into world coordinate
-          Jrot = crossProduct(Jrot, conv_vec2arr(pos_world-(j->X().pos+j->X().rot*a->Q.pos)));  //cross-product of all 4 w-vectors with lever
-          Jrot /= sqrt(sumOfSqr(q({j->qIndex+offset, j->qIndex+offset+3})));   //account for the potential non-normalization of q
-          //          for(uint i=0;i<4;i++) for(uint k=0;k<3;k++) J.elem(k,j_idx+offset+i) += Jrot(k,i);
-          Jrot *= j->scale;
-          J.setMatrixBlock(Jrot, 0, j_idx+offset);
-        }
-      }
-    }
-    a = a->parent;
+  self->jointChains.ensure(frames, N);
+  std::pair<uint, uint> chain = self->jointChains.ranges[a->ID];
+  for(const JointChainLink* l=self->jointChains.links.data()+chain.first, *lend=self->jointChains.links.data()+chain.second; l!=lend; l++) {
+    if(l->isRoot) break; //frame has no inlink -> done
+    addJointJacobian_pos(J, l->type, l->qIndex, l->scale, l->joint->axis, l->joint->X(), l->frame->Q, q.p+l->qIndex, pos_world);
   }
-
-//  if(isSparseMatrix(J) && xIndex) {
-//    J.sparse().reshape(J.d0, J.d1+xIndex);
-//    J.sparse().rowShift(xIndex);
-//  }
 }
 
 /// what is the angular velocity of frame a for a given joint velocity?
@@ -1600,33 +1809,234 @@ void Configuration::jacobian_angular(arr& J, Frame* a) const {
   jacobian_zero(J, 3);
   if(!J) return;
 
-  while(a) { //loop backward down the kinematic tree
-    Joint* j=a->joint;
-    if(j && j->active) {
-      uint j_idx=j->qIndex;
-      if(j_idx>=N) CHECK_EQ(j->type, JT_rigid, "");
-      if(j_idx<N) {
-        if((j->type>=JT_hingeX && j->type<=JT_hingeZ) || j->type==JT_transXYPhi || j->type==JT_phiTransXY) {
-          if(j->type==JT_transXYPhi) j_idx += 2; //refer to the phi only
-          J.elem(0, j_idx) += j->scale * j->axis.x;
-          J.elem(1, j_idx) += j->scale * j->axis.y;
-          J.elem(2, j_idx) += j->scale * j->axis.z;
-        }
-        if(j->type==JT_quatBall || j->type==JT_free || j->type==JT_XBall) {
-          uint offset = 0;
-          if(j->type==JT_XBall) offset=1;
-          if(j->type==JT_free) offset=3;
-          arr Jrot = j->X().rot.getArr() * a->get_Q().rot.getJacobian(); //transform w-vectors into world coordinate
-          Jrot /= sqrt(sumOfSqr(q({j->qIndex+offset, j->qIndex+offset+3}))); //account for the potential non-normalization of q
-          //          for(uint i=0;i<4;i++) for(uint k=0;k<3;k++) J.elem(k,j_idx+offset+i) += Jrot(k,i);
-          Jrot *= j->scale;
-          J.setMatrixBlock(Jrot, 0, j_idx+offset);
+  self->jointChains.ensure(frames, N);
+  std::pair<uint, uint> chain = self->jointChains.ranges[a->ID];
+  for(const JointChainLink* l=self->jointChains.links.data()+chain.first, *lend=self->jointChains.links.data()+chain.second; l!=lend; l++) {
+    if((l->type>=JT_hingeX && l->type<=JT_hingeZ) || l->type==JT_transXYPhi || l->type==JT_phiTransXY) {
+      addColumn(J, l->type==JT_transXYPhi ? l->qIndex+2 : l->qIndex, l->joint->axis, l->scale); //no need for X() of root frames
+    } else if(l->type==JT_quatBall || l->type==JT_free || l->type==JT_XBall) {
+      addJointJacobian_angular(J, l->type, l->qIndex, l->scale, l->joint->axis, l->joint->X(), l->frame->get_Q(), q.p+l->qIndex);
+    }
+  }
+}
+
+/// a frame of the batched forward kinematics program
+struct BatchFKFrame {
+  Frame* frame;
+  int parent;        //program index of the parent; -1: root frame, Q is its (constant) absolute pose
+  Transformation Q;  //constant relative pose if there is no joint
+  Joint* joint;      //active joint with dofs, if any
+  Joint* source;     //the joint that sets Q: the joint itself or the one it mimics
+  Vector axis;       //the joint axis in parent coordinates
+};
+
+static Vector localJointAxis(JointType type) {
+  switch(type) {
+    case JT_hingeX: case JT_transX: case JT_XBall: return Vector_x;
+    case JT_hingeY: case JT_transY: return Vector_y;
+    case JT_hingeZ: case JT_transZ: case JT_transXYPhi: case JT_transYPhi: case JT_phiTransXY: return Vector_z;
+    default: return Vector(0.);
+  }
+}
+
+/// in a block of B samples, poses are stored struct-of-arrays: 7 rows (pos xyz, quat wxyz) of B doubles
+static void batchSetConstant(double* X, const Transformation& Q, uint B) {
+  const double v[7] = {Q.pos.x, Q.pos.y, Q.pos.z, Q.rot.w, Q.rot.x, Q.rot.y, Q.rot.z};
+  for(uint c=0; c<7; c++) for(uint s=0; s<B; s++) X[c*B+s]=v[c];
+}
+
+static void batchSetRad(double* w, double* r, const double* q, uint qStride, double scale, uint n) {
+  for(uint s=0; s<n; s++) { double a=.5*scale*q[s*qStride]; w[s]=cos(a); r[s]=sin(a); }
+}
+
+static void batchSetQuat(double* L, const double* q, uint qStride, double scale, uint n, uint B) {
+  for(uint s=0; s<n; s++) {
+    const double* qs=q+s*qStride;
+    double norm = scale*sqrt(qs[0]*qs[0]+qs[1]*qs[1]+qs[2]*qs[2]+qs[3]*qs[3]);
+    for(uint c=0; c<4; c++) L[(3+c)*B+s] = scale*qs[c]/fabs(norm);
+  }
+}
+
+/// the relative poses L of a joint frame for n samples, as Joint::setDofs computes them; q points to the joint's dofs of
+/// the first sample
+static void batchJointQ(double* L, JointType type, const double* q, uint qStride, double scale, uint n, uint B) {
+  batchSetConstant(L, Transformation_Id, B);
+  double *px=L, *py=L+B, *pz=L+2*B, *qw=L+3*B, *qx=L+4*B, *qy=L+5*B, *qz=L+6*B;
+  switch(type) {
+    case JT_hingeX: batchSetRad(qw, qx, q, qStride, scale, n); break;
+    case JT_hingeY: batchSetRad(qw, qy, q, qStride, scale, n); break;
+    case JT_hingeZ: batchSetRad(qw, qz, q, qStride, scale, n); break;
+    case JT_universal:
+      for(uint s=0; s<n; s++) {
+        double a=.5*scale*q[s*qStride], b=.5*scale*q[s*qStride+1];
+        double ca=cos(a), sa=sin(a), cb=cos(b), sb=sin(b);
+        qw[s]=ca*cb;  qx[s]=sa*cb;  qy[s]=ca*sb;  qz[s]=sa*sb;
+      }
+      break;
+    case JT_quatBall: batchSetQuat(L, q, qStride, scale, n, B); break;
+    case JT_free:
+      for(uint s=0; s<n; s++) { px[s]=scale*q[s*qStride];  py[s]=scale*q[s*qStride+1];  pz[s]=scale*q[s*qStride+2]; }
+      batchSetQuat(L, q+3, qStride, scale, n, B);
+      break;
+    case JT_XBall:
+      for(uint s=0; s<n; s++) px[s]=scale*q[s*qStride];
+      batchSetQuat(L, q+1, qStride, scale, n, B);
+      break;
+    case JT_transX: for(uint s=0; s<n; s++) px[s]=scale*q[s*qStride]; break;
+    case JT_transY: for(uint s=0; s<n; s++) py[s]=scale*q[s*qStride]; break;
+    case JT_transZ: for(uint s=0; s<n; s++) pz[s]=scale*q[s*qStride]; break;
+    case JT_transXY:
+      for(uint s=0; s<n; s++) { px[s]=scale*q[s*qStride];  py[s]=scale*q[s*qStride+1]; }
+      break;
+    case JT_transXYZ: case JT_trans3:
+      for(uint s=0; s<n; s++) { px[s]=scale*q[s*qStride];  py[s]=scale*q[s*qStride+1];  pz[s]=scale*q[s*qStride+2]; }
+      break;
+    case JT_transXYPhi:
+      for(uint s=0; s<n; s++) { px[s]=scale*q[s*qStride];  py[s]=scale*q[s*qStride+1]; }
+      batchSetRad(qw, qz, q+2, qStride, scale, n);
+      break;
+    case JT_transYPhi:
+      for(uint s=0; s<n; s++) py[s]=scale*q[s*qStride];
+      batchSetRad(qw, qz, q+1, qStride, scale, n);
+      break;
+    case JT_phiTransXY:
+      batchSetRad(qw, qz, q, qStride, scale, n);
+      for(uint s=0; s<n; s++) { //pos = rotZ(phi)*(x, y, 0)
+        double x=scale*q[s*qStride+1], y=scale*q[s*qStride+2];
+        double c=qw[s]*qw[s]-qz[s]*qz[s], si=2.*qw[s]*qz[s];
+        px[s]=c*x-si*y;  py[s]=si*x+c*y;
+      }
+      break;
+    default: NIY;
+  }
+}
+
+/// X = P*L for a block of samples; branch-free so that the sample loop vectorizes
+static void batchCompose(double* X, const double* P, const double* L, uint B) {
+  const double *ppx=P, *ppy=P+B, *ppz=P+2*B, *pw=P+3*B, *pqx=P+4*B, *pqy=P+5*B, *pqz=P+6*B;
+  const double *lpx=L, *lpy=L+B, *lpz=L+2*B, *lw=L+3*B, *lqx=L+4*B, *lqy=L+5*B, *lqz=L+6*B;
+  for(uint s=0; s<B; s++) {
+    //rotate the relative position: v + w*t + u x t, with t = 2 u x v
+    double tx = 2.*(pqy[s]*lpz[s] - pqz[s]*lpy[s]);
+    double ty = 2.*(pqz[s]*lpx[s] - pqx[s]*lpz[s]);
+    double tz = 2.*(pqx[s]*lpy[s] - pqy[s]*lpx[s]);
+    X[s]     = ppx[s] + lpx[s] + pw[s]*tx + pqy[s]*tz - pqz[s]*ty;
+    X[B+s]   = ppy[s] + lpy[s] + pw[s]*ty + pqz[s]*tx - pqx[s]*tz;
+    X[2*B+s] = ppz[s] + lpz[s] + pw[s]*tz + pqx[s]*ty - pqy[s]*tx;
+    X[3*B+s] = pw[s]*lw[s] - pqx[s]*lqx[s] - pqy[s]*lqy[s] - pqz[s]*lqz[s];
+    X[4*B+s] = pw[s]*lqx[s] + pqx[s]*lw[s] + pqy[s]*lqz[s] - pqz[s]*lqy[s];
+    X[5*B+s] = pw[s]*lqy[s] + pqy[s]*lw[s] + pqz[s]*lqx[s] - pqx[s]*lqz[s];
+    X[6*B+s] = pw[s]*lqz[s] + pqz[s]*lw[s] + pqx[s]*lqy[s] - pqy[s]*lqx[s];
+  }
+}
+
+static Transformation batchPose(const double* X, uint s, uint B) {
+  Transformation T;
+  T.pos.set(X[s], X[B+s], X[2*B+s]);
+  T.rot.set(X[3*B+s], X[4*B+s], X[5*B+s], X[6*B+s]);
+  return T;
+}
+
+/** forward kinematics for many joint states at once: qBatch is S x d (d = getJointStateDimension()); X becomes S x F.N x 7
+ *  (the absolute poses of the frames F, as in getFrameState); the optional Jpos and Jang become S x F.N x 3 x d (the
+ *  dense position and angular Jacobians, as jacobian_pos and jacobian_angular). The state of this configuration is not
+ *  changed. The ancestors of F are compiled into a topologically sorted program, which is evaluated on blocks of
+ *  samples in struct-of-arrays layout, the blocks in parallel on the thread pool. */
+void Configuration::kinematicsBatch(arr& X, arr& Jpos, arr& Jang, const arr& qBatch, const FrameL& F) const {
+  uint d = getJointStateDimension();
+  CHECK_EQ(qBatch.nd, 2, "joint states need to be given as rows of a matrix");
+  CHECK_EQ(qBatch.d1, d, "joint state dimension mismatch");
+  uint S = qBatch.d0;
+
+  //-- compile the program: ancestors of F, parents first
+  std::vector<int> index(frames.N, -1);
+  std::vector<BatchFKFrame> prog;
+  FrameL path;
+  for(Frame* f:F) {
+    CHECK_EQ(&f->C, this, "given frame is not element of this Configuration");
+    path.clear();
+    for(Frame* a=f; a && index[a->ID]<0; a=a->parent) path.append(a);
+    for(uint i=path.N; i--;) {
+      Frame* a=path.elem(i);
+      BatchFKFrame b;
+      b.frame = a;
+      b.parent = a->parent ? index[a->parent->ID] : -1;
+      b.joint = b.source = 0;
+      Joint* j = a->joint;
+      if(!a->parent) b.Q = a->ensure_X();
+      else if(j && j->active && j->qIndex<d && j->type!=JT_rigid && j->type!=JT_tau) {
+        b.joint = j;
+        b.source = j->mimic ? j->mimic : j;
+        b.axis = localJointAxis(j->type);
+      } else b.Q = a->get_Q();
+      index[a->ID] = prog.size();
+      prog.push_back(b);
+    }
+  }
+
+  //-- the joint chains of the query frames, as program indices
+  bool jac = !!Jpos || !!Jang;
+  std::vector<uint> chainLinks, chainBegin;
+  if(jac) {
+    for(Frame* f:F) {
+      chainBegin.push_back(chainLinks.size());
+      for(Frame* a=f; a->parent; a=a->parent) if(prog[index[a->ID]].joint) chainLinks.push_back(index[a->ID]);
+    }
+    chainBegin.push_back(chainLinks.size());
+  }
+
+  X.resize(S, F.N, 7);
+  if(!!Jpos) Jpos.resize(uintA{S, F.N, 3, d}).setZero();
+  if(!!Jang) Jang.resize(uintA{S, F.N, 3, d}).setZero();
+
+  //-- evaluate blocks of samples in parallel
+  const uint B=16;
+  uint nP=prog.size();
+  struct Scratch { arr X, L, J; };
+  WorkerScratch<Scratch> scratch;
+  parallel_for(0, (S+B-1)/B, [&](uint block) {
+    Scratch& w = scratch();
+    w.X.resize(nP*7*B);
+    w.L.resize(nP*7*B);
+    uint s0 = block*B, n = rai::MIN(B, S-s0);
+    for(uint k=0; k<nP; k++) {
+      const BatchFKFrame& b = prog[k];
+      double *Xk = w.X.p+k*7*B, *Lk = w.L.p+k*7*B;
+      if(b.parent<0) { batchSetConstant(Xk, b.Q, B); continue; }
+      if(b.joint) {
+        batchJointQ(Lk, b.source->type, qBatch.p+s0*d+b.source->qIndex, d, b.source->scale, n, B);
+      } else batchSetConstant(Lk, b.Q, B);
+      batchCompose(Xk, w.X.p+b.parent*7*B, Lk, B);
+    }
+
+    for(uint i=0; i<F.N; i++) {
+      const double* Xi = w.X.p+index[F.elem(i)->ID]*7*B;
+      for(uint s=0; s<n; s++) for(uint c=0; c<7; c++) X.p[((s0+s)*F.N+i)*7+c] = Xi[c*B+s];
+    }
+    if(!jac) return;
+
+    for(uint s=0; s<n; s++) {
+      const double* qs = qBatch.p+(s0+s)*d;
+      for(uint i=0; i<F.N; i++) {
+        Vector pos_world = batchPose(w.X.p+index[F.elem(i)->ID]*7*B, s, B).pos;
+        for(uint m=0; m<2; m++) {
+          arr& Jout = m ? Jang : Jpos;
+          if(!Jout) continue;
+          w.J.resize(3, d).setZero();
+          for(uint l=chainBegin[i]; l<chainBegin[i+1]; l++) {
+            const BatchFKFrame& b = prog[chainLinks[l]];
+            Joint* j = b.joint;
+            Transformation from = batchPose(w.X.p+b.parent*7*B, s, B);
+            Transformation Q = batchPose(w.L.p+chainLinks[l]*7*B, s, B);
+            Vector axis = from.rot*b.axis;
+            if(!m) addJointJacobian_pos(w.J, j->type, j->qIndex, j->scale, axis, from, Q, qs+j->qIndex, pos_world);
+            else addJointJacobian_angular(w.J, j->type, j->qIndex, j->scale, axis, from, Q, qs+j->qIndex);
+          }
+          memmove(Jout.p+((s0+s)*F.N+i)*3*d, w.J.p, w.J.sizeT*w.J.N);
         }
-        //all other joints: J=0 !!
       }
     }
-    a = a->parent;
-  }
+  }, 1);
 }
 
 /// how does the time coordinate of frame a change with q-change?
@@ -1928,6 +2338,10 @@ void Configuration::swiftDelete() {
   self->swift.reset();
 }
 
+void Configuration::fclDelete() {
+  self->fcl.reset();
+}
+
 /// return a PhysX extension
 PhysXInterface& Configuration::physx() {
   if(!self->physx) {
@@ -2175,7 +2589,7 @@ void Configuration::copyProxies(const ProxyA& _proxies) {
 
 /// prototype for \c operator<<
 void Configuration::write(std::ostream& os, bool explicitlySorted) const {
-  for(Frame* f: frames) if(!f->name.N) f->name <<'_' <<f->ID;
+  for(Frame* f: frames) if(!f->name.N) f->setName(STRING('_' <<f->ID));
   if(!explicitlySorted){
     for(Frame* f: frames) f->write(os);
   }else{
@@ -2186,7 +2600,7 @@ void Configuration::write(std::ostream& os, bool explicitlySorted) const {
 }
 
 void Configuration::write(Graph& G) const {
-  for(Frame* f: frames) if(!f->name.N) f->name <<'_' <<f->ID;
+  for(Frame* f: frames) if(!f->name.N) f->setName(STRING('_' <<f->ID));
   for(Frame* f: frames) f->write(G.newSubgraph({f->name}));
 }
 
@@ -2359,7 +2773,8 @@ void Configuration::writeMeshes(const char* pathPrefix) const {
       if(f->shape->type()==ST_ssCvx) f->shape->sscCore().writeArr(FILE(filename));
 #else
       filename <<f->name <<".ply";
-      f->ats->getNew<FileToken>("mesh").name = filename;
+      if(!f->ats) f->ats = make_shared<Graph>();
+      copyOnWrite(f->ats).getNew<FileToken>("mesh").name = filename; //the attributes may be shared with a copy
       if(f->shape->type()==ST_mesh) f->shape->mesh().writePLY(filename.p);
       if(f->shape->type()==ST_ssCvx) f->shape->sscCore().writePLY(filename.p);
 #endif
@@ -2385,16 +2800,16 @@ Graph Configuration::getGraph() const {
     Node* n = G.elem(f->ID);
     if(f->parent) {
       n->addParent(G.elem(f->parent->ID));
-      n->key = STRING("Q= " <<f->get_Q());
+      n->setKey(STRING("Q= " <<f->get_Q()));
     }
     if(f->joint) {
-      n->key = (STRING("joint " <<f->joint->type));
+      n->setKey(STRING("joint " <<f->joint->type));
     }
     if(f->shape) {
-      n->key = (STRING("shape " <<f->shape->type()));
+      n->setKey(STRING("shape " <<f->shape->type()));
     }
     if(f->inertia) {
-      n->key = (STRING("inertia m=" <<f->inertia->mass));
+      n->setKey(STRING("inertia m=" <<f->inertia->mass));
     }
   }
 #else
@@ -125,6 +125,7 @@ struct Configuration : GLDrawer {
   arr getJointStateSlice(uint t, bool activesOnly=true){  return getJointState(getJointsSlice(t, activesOnly));  }
   arr getFrameState() const { return getFrameState(frames); } ///< same as getFrameState() for all \ref frames
   arr getFrameState(const FrameL& F) const;
+  void getFrameState(arr& X, const FrameL& F) const; ///< same, into a given buffer (resized only if needed)
   arr getFrameState(const uintA& F) const { return getFrameState(getFrames(F)); } ///< same as getFrameState() with getFrames()
 
   /// @name set state
@@ -161,6 +162,12 @@ struct Configuration : GLDrawer {
   /// @name structural operations, changes of configuration
   void clear();
   void reset_q();
+  void reset_frameNameIndex(); ///< needed after frames were renamed other than by setName/prefixNames
+  void reindexFrameName(Frame* f, const char* oldName); ///< update the name index after f was renamed (done by Frame::setName)
+  void unindexFrame(Frame* f); ///< drop a deleted frame from the name index (done by ~Frame)
+  void reset_jointChains();    ///< drop the precompiled joint chains (done by reset_q, calc_indexedActiveJoints and relinking)
+  Transformation* allocFramePoses();        ///< storage for a new frame's Q and X (two consecutive transformations) in the pose pool
+  void freeFramePoses(Transformation* QX); ///< return a deleted frame's poses to the pool
   void reconfigureRoot(Frame* newRoot, bool ofLinkOnly);  ///< n becomes the root of the kinematic tree; joints accordingly reversed; lists resorted
   void flipFrames(Frame* a, Frame* b);
   void pruneRigidJoints();        ///< delete rigid joints -> they become just links
@@ -190,6 +197,8 @@ struct Configuration : GLDrawer {
   void ensure_indexedJoints() {   if(!_state_indexedJoints_areGood) calc_indexedActiveJoints();  }
   void ensure_q() {  if(!_state_q_isGood) calcDofsFromConfig();  }
   void ensure_proxies() {  if(!_state_proxies_isGood) stepSwift();  }
+  void ensure_jointChains() const; ///< precompile the joint chains of all frames (otherwise done by the first Jacobian)
+  void ensure_frameNameIndex() const; ///< index the names of all frames (otherwise done by getFrame)
 
   /// @name Jacobians and kinematics (low level)
   void jacobian_pos(arr& J, Frame* a, const Vector& pos_world) const; //usually called internally with kinematicsPos
@@ -208,6 +217,7 @@ struct Configuration : GLDrawer {
   void hessianPos(arr& H, Frame* a, Vector* rel=0) const;
   void kinematicsTau(double& tau, arr& J, Frame* a=0) const;
 
+  void kinematicsBatch(arr& X, arr& Jpos, arr& Jang, const arr& qBatch, const FrameL& F) const; ///< poses (and Jacobians) of F for many joint states (rows of qBatch) at once, without changing the state
   void kinematicsPenetration(arr& y, arr& J, const Proxy& p, double margin=.0, bool addValues=false) const;
   void kinematicsPenetration(arr& y, arr& J, double margin=.0) const;
 
@@ -236,6 +246,7 @@ struct Configuration : GLDrawer {
   std::shared_ptr<SwiftInterface> swift();
   std::shared_ptr<FclInterface> fcl();
   void swiftDelete();
+  void fclDelete(); ///< drop the fcl models (they refer to the mesh data; done by Shape::modifyMesh)
   PhysXInterface& physx();
   OdeInterface& ode();
   FeatherstoneInterface& fs();
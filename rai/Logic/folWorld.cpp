@@ -131,10 +131,10 @@ TreeSearchDomain::TransitionReturn FOL_World::transition(const Handle& action) {
     NodeL decisionTuple = {d->rule};
     decisionTuple.append(d->substitution);
     lastDecisionInState = createNewFact(*state, decisionTuple);
-    lastDecisionInState->key = ("decision");
+    lastDecisionInState->setKey("decision");
   } else {
     lastDecisionInState = createNewFact(*state, {Wait_keyword});
-    lastDecisionInState->key = ("decision");
+    lastDecisionInState->setKey("decision");
   }
 
   //-- apply effects of decision
@@ -292,7 +292,7 @@ void FOL_World::make_current_state_new_start() {
   if(!start_state) start_state = &KB.newSubgraph({"START_STATE"}, state->isNodeOfGraph->parents);
   state->index();
   start_state->copy(*state);
-  start_state->isNodeOfGraph->key="START_STATE";
+  start_state->isNodeOfGraph->setKey("START_STATE");
   start_T_step = T_step;
   start_T_real = T_real;
   DEBUG(KB.checkConsistency();)
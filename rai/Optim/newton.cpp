@@ -129,7 +129,8 @@ OptNewton::StopCriterion OptNewton::step() {
     bool inversionFailed=false;
     try {
       if(!rootFinding) {
-        Delta = lapack_Ainv_b_sym(R, -gx);
+        if(isSparseMatrix(R)) Delta = sparseSolver.Ainv_b(R, -gx);
+        else Delta = lapack_Ainv_b_sym(R, -gx);
       } else {
         lapack_mldivide(Delta, R, -gx);
       }
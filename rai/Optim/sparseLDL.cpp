@@ -0,0 +1,176 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#include "sparseLDL.h"
+
+#include <set>
+#include <algorithm>
+
+//===========================================================================
+
+/// greedy minimum degree on the explicit elimination graph (ties broken by lowest index, so the ordering is deterministic)
+uintA minimumDegreeOrdering(const rai::SparseMatrix& A) {
+  uint n = A.Z.d0;
+  std::vector<std::vector<uint>> adj(n);
+  for(uint k=0; k<A.elems.d0; k++) {
+    uint i=A.elems.p[2*k], j=A.elems.p[2*k+1];
+    if(i!=j) { adj[i].push_back(j); adj[j].push_back(i); }
+  }
+  std::set<std::pair<uint, uint>> queue; //(degree, node)
+  for(uint i=0; i<n; i++) {
+    std::sort(adj[i].begin(), adj[i].end());
+    adj[i].erase(std::unique(adj[i].begin(), adj[i].end()), adj[i].end());
+    queue.insert({adj[i].size(), i});
+  }
+
+  uintA order;
+  std::vector<uint> merged;
+  while(queue.size()) {
+    uint v = queue.begin()->second;
+    queue.erase(queue.begin());
+    order.append(v);
+    //eliminating v makes its neighbors a clique
+    for(uint u:adj[v]) {
+      merged.clear();
+      std::set_union(adj[u].begin(), adj[u].end(), adj[v].begin(), adj[v].end(), std::back_inserter(merged));
+      merged.erase(std::remove_if(merged.begin(), merged.end(), [u, v](uint w) { return w==u || w==v; }), merged.end());
+      queue.erase({adj[u].size(), u});
+      adj[u].swap(merged);
+      queue.insert({adj[u].size(), u});
+    }
+    adj[v].clear();
+  }
+  return order;
+}
+
+//===========================================================================
+
+void SparseLDL::clear() {
+  pattern.clear();
+  perm.clear(); permInv.clear(); parent.clear(); Lstart.clear();
+  Cstart.clear(); Crow.clear(); Cmem.clear();
+  Lrow.clear(); Lval.clear(); D.clear();
+}
+
+void SparseLDL::analyze(const rai::SparseMatrix& A) {
+  uint n = A.Z.d0;
+  CHECK_EQ(A.Z.d1, n, "LDL needs a square matrix");
+  analyses++;
+  pattern = A.elems;
+
+  //-- fill-reducing ordering
+  perm = minimumDegreeOrdering(A);
+  permInv.resize(n);
+  for(uint k=0; k<n; k++) permInv(perm(k)) = k;
+
+  //-- upper triangle of P A P^T by columns
+  Cstart.resize(n+1).setZero();
+  uint nUp=0, nLo=0;
+  for(uint k=0; k<A.elems.d0; k++) {
+    uint i=permInv.p[A.elems.p[2*k]], j=permInv.p[A.elems.p[2*k+1]];
+    if(i<=j) Cstart.p[j+1]++;
+    if(i<j) nUp++;
+    if(i>j) nLo++;
+  }
+  CHECK_EQ(nUp, nLo, "the sparse matrix needs to store both triangles of the symmetric matrix");
+  for(uint j=0; j<n; j++) Cstart.p[j+1] += Cstart.p[j];
+  Crow.resize(Cstart.last());
+  Cmem.resize(Cstart.last());
+  uintA c = Cstart;
+  for(uint k=0; k<A.elems.d0; k++) {
+    uint i=permInv.p[A.elems.p[2*k]], j=permInv.p[A.elems.p[2*k+1]];
+    if(i>j) continue;
+    uint l = c.p[j]++;
+    Crow.p[l] = i;
+    Cmem.p[l] = k;
+  }
+
+  //-- elimination tree and column counts of L
+  parent.resize(n) = UINT_MAX;
+  uintA flag(n), Lnz(n);
+  Lnz.setZero();
+  for(uint k=0; k<n; k++) {
+    flag.p[k] = k;
+    for(uint l=Cstart.p[k]; l<Cstart.p[k+1]; l++) {
+      for(uint i=Crow.p[l]; i<k && flag.p[i]!=k; i=parent.p[i]) {
+        if(parent.p[i]==UINT_MAX) parent.p[i]=k;
+        Lnz.p[i]++;
+        flag.p[i] = k;
+      }
+    }
+  }
+  Lstart.resize(n+1);
+  Lstart.p[0]=0;
+  for(uint k=0; k<n; k++) Lstart.p[k+1] = Lstart.p[k]+Lnz.p[k];
+  Lrow.resize(Lstart.last());
+  Lval.resize(Lstart.last());
+}
+
+void SparseLDL::factorize(const arr& A) {
+  CHECK(isSparseMatrix(A), "");
+  const rai::SparseMatrix& S = A.sparse();
+  if(perm.N!=A.d0 || pattern.N!=S.elems.N || memcmp(pattern.p, S.elems.p, pattern.N*sizeof(int))) analyze(S);
+  factorizations++;
+
+  //-- up-looking numeric factorization: row k of L from a sparse triangular solve along the elimination tree
+  uint n = A.d0;
+  arr Y(n);
+  Y.setZero();
+  uintA stack(n), flag(n), Lnz(n);
+  D.resize(n);
+  for(uint k=0; k<n; k++) {
+    uint top=n;
+    flag.p[k] = k;
+    Lnz.p[k] = 0;
+    for(uint l=Cstart.p[k]; l<Cstart.p[k+1]; l++) {
+      uint i = Crow.p[l];
+      Y.p[i] += A.p[Cmem.p[l]];
+      uint len=0;
+      for(; flag.p[i]!=k; i=parent.p[i]) { stack.p[len++]=i; flag.p[i]=k; }
+      while(len) stack.p[--top] = stack.p[--len];
+    }
+    D.p[k] = Y.p[k];
+    Y.p[k] = 0.;
+    for(; top<n; top++) {
+      uint i = stack.p[top];
+      double yi = Y.p[i];
+      Y.p[i] = 0.;
+      uint p, pEnd=Lstart.p[i]+Lnz.p[i];
+      for(p=Lstart.p[i]; p<pEnd; p++) Y.p[Lrow.p[p]] -= Lval.p[p]*yi;
+      double lki = yi/D.p[i];
+      D.p[k] -= lki*yi;
+      Lrow.p[pEnd] = k;
+      Lval.p[pEnd] = lki;
+      Lnz.p[i]++;
+    }
+    if(!(D.p[k]>0.)) {
+      Y.setZero();
+      THROW("SparseLDL: matrix is not positive definite (D(" <<k <<")=" <<D.p[k] <<")");
+    }
+  }
+}
+
+arr SparseLDL::solve(const arr& b) const {
+  uint n = perm.N;
+  CHECK_EQ(b.N, n, "");
+  arr x(n);
+  for(uint k=0; k<n; k++) x.p[k] = b.p[perm.p[k]];
+  for(uint j=0; j<n; j++) {
+    double xj = x.p[j];
+    for(uint p=Lstart.p[j]; p<Lstart.p[j+1]; p++) x.p[Lrow.p[p]] -= Lval.p[p]*xj;
+  }
+  for(uint j=0; j<n; j++) x.p[j] /= D.p[j];
+  for(uint j=n; j--;) {
+    double xj = x.p[j];
+    for(uint p=Lstart.p[j]; p<Lstart.p[j+1]; p++) xj -= Lval.p[p]*x.p[Lrow.p[p]];
+    x.p[j] = xj;
+  }
+  arr y(n);
+  for(uint k=0; k<n; k++) y.p[perm.p[k]] = x.p[k];
+  return y;
+}
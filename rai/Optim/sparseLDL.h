@@ -0,0 +1,42 @@
+/*  ------------------------------------------------------------------
+    Copyright (c) 2011-2020 Marc Toussaint
+    email: toussaint@tu-berlin.de
+
+    This code is distributed under the MIT License.
+    Please see <root-path>/LICENSE for details.
+    --------------------------------------------------------------  */
+
+#pragma once
+
+#include "../Core/array.h"
+
+//===========================================================================
+
+/** Sparse LDL^T factorization of a symmetric positive definite rai::SparseMatrix (both triangles stored,
+ *  duplicate entries are summed). The symbolic analysis (fill-reducing ordering, elimination tree,
+ *  structure of L) is cached and only redone when the sparsity pattern of the matrix changes;
+ *  successive factorizations of matrices with the same pattern only redo the numeric part. */
+struct SparseLDL {
+  //-- symbolic analysis
+  intA pattern;          ///< the (row,col) pattern the analysis was done for
+  uintA perm, permInv;   ///< fill-reducing ordering: row/col k of the factor is row/col perm(k) of A
+  uintA parent;          ///< elimination tree of the permuted matrix (UINT_MAX for roots)
+  uintA Lstart;          ///< column k of L holds the non-zeros [Lstart(k),Lstart(k+1))
+  uintA Cstart, Crow, Cmem; ///< upper triangle of the permuted matrix by columns: column j has rows Crow(l) and value A.Z(Cmem(l)), l in [Cstart(j),Cstart(j+1))
+
+  //-- numeric factor
+  uintA Lrow;            ///< row index of each non-zero of L
+  arr Lval;              ///< value of each non-zero of L (unit diagonal not stored)
+  arr D;                 ///< the diagonal
+
+  uint analyses=0, factorizations=0;
+
+  void factorize(const arr& A);   ///< analyzes A if its pattern differs from the last one, then factorizes numerically
+  arr solve(const arr& b) const;  ///< solves A x = b with the last factorization
+  arr Ainv_b(const arr& A, const arr& b) { factorize(A); return solve(b); }
+
+  void analyze(const rai::SparseMatrix& A);
+  void clear();
+};
+
+uintA minimumDegreeOrdering(const rai::SparseMatrix& A);
@@ -180,9 +180,9 @@ void init_Frame(pybind11::module& m) {
     CHECK(self->shape, "this frame is not a mesh!");
     CHECK_EQ(self->shape->type(), rai::ST_mesh, "this frame is not a mesh!");
     uint n = lines.size()/3;
-    self->shape->mesh().V = lines;
-    self->shape->mesh().V.reshape(n, 3);
-    uintA& T = self->shape->mesh().T;
+    self->shape->modifyMesh().V = lines;
+    self->shape->modifyMesh().V.reshape(n, 3);
+    uintA& T = self->shape->modifyMesh().T;
     T.resize(n/2, 2);
     for(uint i=0; i<T.d0; i++) {
       T(i, 0) = 2*i;
@@ -381,6 +381,99 @@ void TEST(MemoryBound){
 
 //===========================================================================
 
+void TEST(MemoryProfile){
+  cout <<"\n*** allocation profile\n";
+  rai::memoryProfileReset();
+  rai::globalMemoryProfile=true;
+  {
+    arr A;
+    for(uint i=0;i<100;i++) A.append(ones(100));
+    floatA F(1000);
+  }
+  { floatA F(1<<18); } //two sites of 1MB floats, never live at the same time
+  { floatA G; G.resize(1<<18); }
+  rai::globalMemoryProfile=false;
+  std::ostringstream report;
+  rai::memoryProfileReport(report, 5);
+  cout <<report.str();
+  CHECK(report.str().find("0.000MB still live")!=std::string::npos, "profiled arrays were not released");
+  CHECK(report.str().find("float")!=std::string::npos, "allocations are not recorded per type");
+  CHECK(report.str().find("peak     1.000MB  live     0.000MB  float\n")!=std::string::npos, "per type peak is not the peak of live bytes");
+}
+
+//===========================================================================
+
+void TEST(InlineStorage){
+  cout <<"\n*** inline storage of small arrays\n";
+  typedef rai::SmallArray<double> arrS;
+  //only SmallArrays carry an inline buffer
+  CHECK_EQ(arr().inlineCapacity(), 0, "");
+  CHECK_GE(sizeof(arrS), sizeof(arr)+16*sizeof(double), "");
+  uint n=arrS().inlineCapacity();
+  CHECK_EQ(n, 16, "");
+
+  //resizeMEM: grow past the capacity and shrink below it again
+  arrS a = range(0., 1., n-2);
+  CHECK(a.isInline(), "");
+  arrS b = range(0., 1., 2*n);
+  CHECK(!b.isInline(), "");
+  arrS c = a;
+  CHECK(c.isInline(), "");
+  c.append(ones(n));
+  CHECK(!c.isInline(), "");
+  CHECK_ZERO(maxDiff(c({0,n-2}), a), 0., "data lost moving to the heap");
+  c.resize(3);
+  c.resize(n+5);
+  c.resize(3);
+  CHECK_ZERO(maxDiff(c, a({0,2})), 0., "data lost moving back");
+
+  //as output argument of functions taking arr&
+  arrS r;
+  r.resize(3).setZero();
+  r += ones(3);
+  CHECK(r.isInline() && sum(r)==3., "");
+
+  //moves from and into plain arrays
+  arrS a2 = range(0., 1., n-2);
+  arr m(std::move(a2));
+  CHECK(!m.isInline() && m.N==n-1 && m.elem(-1)==1., "");
+  arrS m2(std::move(m));
+  CHECK(m2.isInline() && m2.N==n-1 && m2.elem(-1)==1., "");
+  arrS m3(std::move(m2));
+  CHECK(m3.isInline() && m3.N==n-1 && m3.elem(-1)==1., "");
+  arr h = ones(2*n);
+  double* hp = h.p;
+  arrS m4(std::move(h));
+  CHECK(m4.p==hp, "large arrays should be stolen, not copied");
+
+  //swap of all inline/heap combinations
+  arrS x=ones(3), y=zeros(4);
+  arr hx=ones(2*n);
+  x.swap(y);
+  CHECK(x.N==4 && y.N==3 && sum(x)==0. && sum(y)==3., "");
+  x.swap(hx);
+  CHECK(x.N==2*n && hx.N==4 && sum(x)==2.*n && sum(hx)==0., "");
+  x.swap(hx);
+  CHECK(x.N==4 && hx.N==2*n && sum(x)==0. && sum(hx)==2.*n, "");
+
+  //takeOver of inline data
+  arrS s=ones(5);
+  arr t;
+  t.takeOver(s);
+  CHECK(s.isReference && s.p==t.p, "");
+  CHECK_EQ(sum(s), 5., "");
+
+  //raw views into plain arrays survive moves of the owner
+  arr o=ones(4);
+  arr v(o.p, o.N, true);
+  arr o2(std::move(o));
+  CHECK_EQ(v.p, o2.p, "");
+  o2(1)=3.;
+  CHECK_EQ(v(1), 3., "");
+}
+
+//===========================================================================
+
 void TEST(BinaryIO){
   cout <<"\n*** acsii and binary IO\n";
   arr a,b; a.resize(1000,100); rndUniform(a,0.,1.,false);
@@ -416,6 +509,46 @@ void TEST(BinaryIO){
 
 //===========================================================================
 
+void TEST(MappedFile){
+  cout <<"\n*** memory-mapped binary array files\n";
+  arr a(1000,100); rndUniform(a,0.,1.,false);
+  uintA u={1u,2u,3u};
+
+  rai::timerStart();
+  rai::writeArrayFile(a, "z.arr");
+  rai::writeArrayFile(u, "z.uarr");
+  cout <<"mapped write time: " <<rai::timerRead() <<"sec" <<endl;
+
+  {
+    arr b;
+    rai::timerStart();
+    std::shared_ptr<rai::MappedFile> file = rai::mapArrayFile(b, "z.arr");
+    cout <<"mapped load time: " <<rai::timerRead() <<"sec" <<endl;
+    CHECK(b.isReference, "");
+    CHECK_EQ(b.nd, 2, "");
+    CHECK_EQ(a, b, "mapped IO failed!");
+    CHECK_EQ(((size_t)b.p)%64, 0, "mapped data not aligned");
+
+    uintA v;
+    auto file2 = rai::mapArrayFile(v, "z.uarr", true);
+    CHECK_EQ(u, v, "");
+
+    //copy-on-write mappings can be modified without touching the file
+    arr c;
+    auto file3 = rai::mapArrayFile(c, "z.arr", true, true);
+    c(0,0) = -1.;
+    CHECK_EQ(b(0,0), a(0,0), "");
+  }
+
+  //wrong type
+  floatA f;
+  bool caught=false;
+  try{ rai::mapArrayFile(f, "z.arr"); } catch(...) { caught=true; }
+  CHECK(caught, "type mismatch was not detected");
+}
+
+//===========================================================================
+
 void TEST(Expression){
   cout <<"\n*** matrix expressions\n";
   arr a(2,3),b(3,2),c(3),d;
@@ -431,6 +564,36 @@ void TEST(Expression){
   cout <<"\ncoupled unitary\n" <<1. + .5 * (2.*a) - 1.;
   cout <<"\nlonger expression\n" <<2.*a + 3.*a;
   cout <<"\nlonger expression\n" <<2.*a + ~b;
+
+  //expressions on temporaries are evaluated in place: same result, and references are not overwritten
+  arr x = 2.*a + 3.*(a*b*~b) - a/2. + 1.;
+  arr y = a;
+  y *= 2.;
+  arr t = a*b*~b;
+  t *= 3.;
+  y += t;
+  t = a;
+  t /= 2.;
+  y -= t;
+  y += 1.;
+  CHECK_ZERO(maxDiff(x, y), 1e-10, "");
+  arr a0 = a;
+  x = a[0] + c;
+  x = -a[1];
+  x = a[0]*2.;
+  CHECK_EQ(a, a0, "a reference got overwritten");
+
+  //assigning a temporary of fitting size keeps the buffer, so views of the target stay valid
+  arr z = zeros(6), view;
+  view.referTo(z.p, z.N);
+  z = a*2.;
+  CHECK_EQ(view.p, z.p, "");
+  CHECK_EQ(view.elem(5), z.elem(5), "");
+
+  //transposed products without transpose copies
+  CHECK_ZERO(maxDiff(comp_At_A(a), ~a*a), 1e-10, "");
+  CHECK_ZERO(maxDiff(comp_A_At(a), a*~a), 1e-10, "");
+  CHECK_ZERO(maxDiff(comp_At_x(b, c), ~b*c), 1e-10, "");
 }
 
 //===========================================================================
@@ -525,19 +688,47 @@ void TEST(MM){
   double t_native=rai::timerRead();
   cout <<"native time = " <<t_native <<endl;
 
-  if(!rai::lapackSupported){
-    cout <<"LAPACK not installed - only native algorithms" <<endl;
-    return;
-  }
-
   rai::useLapack=true;
   rai::timerStart();
   blas_MM(C,A,B);
-  rai::timerRead();
-  cout <<"blas time = " <<rai::timerRead() <<endl;
+  cout <<(rai::lapackSupported?"blas":"built-in blocked") <<" time = " <<rai::timerRead() <<endl;
 
   CHECK_ZERO(maxDiff(C,D), 1e-10, "blas MM is not equivalent to native matrix multiplication");
 //  CHECK(t_blas < t_native,"blas MM is slower than native");
+
+  //square products, A^T A, A A^T and matrix-vector products against the naive loops
+  for(uint n:{7u, 100u, 500u}){
+    arr X(n,n), Y(n,n), x(n), Z1, Z2;
+    rndUniform(X,-1,1,false);
+    rndUniform(Y,-1,1,false);
+    rndUniform(x,-1,1,false);
+    rai::useLapack=false;
+    rai::timerStart();
+    op_innerProduct(Z1, X, Y);
+    double t_naive=rai::timerRead();
+    rai::useLapack=true;
+    rai::timerStart();
+    blas_MM(Z2, X, Y);
+    double t_blocked=rai::timerRead();
+    cout <<n <<'x' <<n <<": naive time = " <<t_naive <<" blocked time = " <<t_blocked <<endl;
+    CHECK_ZERO(maxDiff(Z1, Z2), 1e-10, "");
+    rai::useLapack=false;
+    arr Xt = ~X;
+    op_innerProduct(Z1, Xt, X);
+    rai::useLapack=true;
+    blas_At_A(Z2, X);
+    CHECK_ZERO(maxDiff(Z1, Z2), 1e-10, "");
+    rai::useLapack=false;
+    op_innerProduct(Z1, X, Xt);
+    rai::useLapack=true;
+    blas_A_At(Z2, X);
+    CHECK_ZERO(maxDiff(Z1, Z2), 1e-10, "");
+    rai::useLapack=false;
+    op_innerProduct(Z1, X, x);
+    rai::useLapack=true;
+    blas_Mv(Z2, X, x);
+    CHECK_ZERO(maxDiff(Z1, Z2), 1e-10, "");
+  }
 }
 
 //===========================================================================
@@ -683,6 +874,41 @@ void TEST(GaussElimintation) {
 
 //===========================================================================
 
+void TEST(Reductions){
+  cout <<"\n*** vectorized reductions and element-wise operators\n";
+  for(uint n:{0u, 3u, 7u, 16u, 33u, 1000u}){
+    arr a=randn(n), b=randn(n);
+    floatA f=convert<float>(a);
+    double s=0., sq=0., ab=0., pos=0., am=0., sp=0., d=0.;
+    for(uint i=0;i<n;i++){
+      s+=a(i); sq+=a(i)*a(i); ab+=fabs(a(i)); if(a(i)>0.) pos+=a(i);
+      if(fabs(a(i))>am) am=fabs(a(i));
+      sp+=a(i)*b(i); d+=rai::sqr(a(i)-b(i));
+    }
+    CHECK_ZERO(sum(a)-s, 1e-10, "");
+    CHECK_ZERO(sumOfSqr(a)-sq, 1e-10, "");
+    CHECK_ZERO(sumOfAbs(a)-ab, 1e-10, "");
+    CHECK_ZERO(sumOfPos(a)-pos, 1e-10, "");
+    CHECK_EQ(absMax(a), am, "");
+    CHECK_ZERO(scalarProduct(a,b)-sp, 1e-10, "");
+    CHECK_ZERO(sqrDistance(a,b)-d, 1e-10, "");
+    CHECK_ZERO(sumOfSqr(f)-sq, 1e-3, "");
+
+    arr c=a;
+    c += b;
+    c *= 2.;
+    c -= a;
+    arr m=elemWiseMin(a,b), M=elemWiseMax(a,b);
+    for(uint i=0;i<n;i++){
+      CHECK_EQ(c(i), 2.*(a(i)+b(i))-a(i), "");
+      CHECK_EQ(m(i), rai::MIN(a(i),b(i)), "");
+      CHECK_EQ(M(i), rai::MAX(a(i),b(i)), "");
+    }
+  }
+}
+
+//===========================================================================
+
 void TEST(Tensor){
   cout <<"\n*** tensor manipulations\n";
 
@@ -788,9 +1014,13 @@ void TEST(RowShifted){
     CHECK_ZERO(maxDiff(Z*X, unpack(Z*Y)), 1e-10, "");
     CHECK_ZERO(maxDiff(X*Z2, unpack(Y*Z2)), 1e-10, "");
 
-    //cholesky:
+    //banded LDL^T solve:
     arr H = comp_A_At(Y);
     addDiag(H, 1.);
+    arr b = randn(H.d0);
+    CHECK_ZERO(maxDiff(unpack(H)*lapack_Ainv_b_sym(H, b), b), 1e-10, "");
+
+    //cholesky:
     arr Hchol;
     lapack_choleskySymPosDef(Hchol, H);
     CHECK_ZERO(maxDiff(comp_At_A(Hchol), H), 1e-10, "");
@@ -838,6 +1068,52 @@ void TEST(SparseMatrix){
     sparseProduct(D, A, B);
     CHECK_EQ(C, D, "");
   }
+
+  //compressed row/column kernels vs. dense products
+  for(uint k=0;k<20;k++){
+    arr A(30,20), B(20,15), x(20), z(30);
+    rndInteger(A,-1,1);
+    for(double& a:A) if(rnd.uni()<.7) a=0.; //keep ~30% non-zeros
+    rndInteger(B,-1,1);
+    rndInteger(x,-2,2);
+    rndInteger(z,-2,2);
+    arr As=A, Bs=B;
+    As.sparse().setFromDense(A);
+    Bs.sparse().setFromDense(B);
+    CHECK_ZERO(maxDiff(As.sparse().A_x(x), A*x), 1e-10, "");
+    CHECK_ZERO(maxDiff(As.sparse().At_x(z), ~A*z), 1e-10, "");
+    CHECK_ZERO(maxDiff(As.sparse().At_A().sparse().unsparse(), ~A*A), 1e-10, "");
+    CHECK_ZERO(maxDiff(As.sparse().A_B(Bs).sparse().unsparse(), A*B), 1e-10, "");
+    CHECK_ZERO(maxDiff(Bs.sparse().B_A(As).sparse().unsparse(), A*B), 1e-10, "");
+
+    //round trip through triplets
+    arr T = As.sparse().getTriplets();
+    arr Ts;
+    Ts.sparse().setFromTriplets(T, A.d0, A.d1);
+    CHECK_EQ(Ts.sparse().unsparse(), A, "");
+  }
+
+  //the compressed index follows every change of the non-zeros
+  {
+    arr A(6,8), x(8);
+    rndInteger(A,-1,1);
+    rndInteger(x,-2,2);
+    for(uint i=0;i<A.d0;i++) A(i,7)=0.;
+    arr As;
+    As.sparse().setFromDense(A);
+    CHECK_ZERO(maxDiff(As.sparse().A_x(x), A*x), 1e-10, "");
+    As.sparse().addEntry(2,3) = 5.;  A(2,3) += 5.;
+    CHECK_ZERO(maxDiff(As.sparse().A_x(x), A*x), 1e-10, "");
+    As.sparse().add(ones(2,2), 1, 4);
+    A(1,4)+=1.; A(1,5)+=1.; A(2,4)+=1.; A(2,5)+=1.;
+    CHECK_ZERO(maxDiff(As.sparse().A_x(x), A*x), 1e-10, "");
+    As.sparse().rowShift(1);
+    arr A1 = zeros(6,8);
+    for(uint i=0;i<6;i++) for(uint j=0;j<7;j++) A1(i,j+1)=A(i,j);
+    CHECK_ZERO(maxDiff(As.sparse().A_x(x), A1*x), 1e-10, "");
+    As.sparse().transpose();
+    CHECK_ZERO(maxDiff(As.sparse().A_x(ones(6)), ~A1*ones(6)), 1e-10, "");
+  }
 }
 
 //===========================================================================
@@ -930,7 +1206,10 @@ int MAIN(int argc, char **argv){
   testMatlab();
   testException();
   testMemoryBound();
+  testMemoryProfile();
+  testInlineStorage();
   testBinaryIO();
+  testMappedFile();
   testExpression();
   testPermutation();
   testGnuplot();
@@ -941,6 +1220,7 @@ int MAIN(int argc, char **argv){
   testSparseMatrix();
   testInverse();
   testMM();
+  testReductions();
   testSVD();
   testPCA();
   testTensor();
@@ -143,6 +143,46 @@ void TEST(Dot){
 
 //===========================================================================
 
+void TEST(KeyIndex){
+  rai::Graph G;
+  for(uint i=0;i<1000;i++) G.newNode<double>(STRING("x" <<i%300), {}, (double)i);
+  CHECK(G.keyIndex, "large graphs should have a key index");
+
+  for(uint k=0;k<300;k++){
+    CHECK_EQ(G.get<double>(STRING("x" <<k)), (double)k, "");
+    CHECK_EQ(G.findNodes(STRING("x" <<k)).N, (k<100?4:3), "");
+  }
+  CHECK(!G.findNode("x300"), "");
+
+  //re-keying and deleting keeps the order of the graph
+  static_assert(!std::is_assignable<decltype((G.elem(0)->key)), const char*>::value, "keys only change through setKey");
+  G.elem(700)->setKey("x1");
+  G.elem(500)->setKey("y");
+  CHECK_EQ(G.findNode("y"), G.elem(500), "");
+  CHECK(!G.findNodes("x200").contains(G.elem(500)), "");
+  CHECK_EQ(G.findNodes("x1"), rai::NodeL({G.elem(1), G.elem(301), G.elem(601), G.elem(700), G.elem(901)}), "");
+  delete G.elem(1);
+  G.index();
+  CHECK_EQ(G.findNode("x1")->get<double>(), 301., "");
+  G.checkConsistency();
+
+  //same results without the index
+  rai::NodeL withIndex = G.findNodes("x1");
+  rai::timerStart();
+  for(uint k=0;k<100000;k++) G.findNode(STRING("x" <<k%300));
+  cout <<"lookups with key index: " <<rai::timerRead() <<"sec" <<endl;
+  G.setKeyIndex(false);
+  CHECK(!G.keyIndex, "");
+  CHECK_EQ(G.findNodes("x1"), withIndex, "");
+  rai::timerStart();
+  for(uint k=0;k<100000;k++) G.findNode(STRING("x" <<k%300));
+  cout <<"lookups scanning:       " <<rai::timerRead() <<"sec" <<endl;
+  G.setKeyIndex(true);
+  G.checkConsistency();
+}
+
+//===========================================================================
+
 struct Something{
   Something(double y=0.){ x=y; }
   double x;
@@ -170,6 +210,7 @@ int MAIN(int argc, char** argv){
   testRead();
   testInit();
   testDot();
+  testKeyIndex();
 
   testManual();
 
@@ -192,6 +192,187 @@ void TEST(Logging){
 
 //===========================================================================
 
+void TEST(ThreadPool){
+  arr x = rand(100000);
+
+  //deterministic reduction: identical for any number of threads
+  auto map = [&x](uint l, uint u){ double s=0.; for(uint i=l;i<u;i++) s += x.elem(i); return s; };
+  auto reduce = [](const double& a, const double& b){ return a+b; };
+  double s1=0.;
+  for(int n:{1, 2, 4, 7}){
+    rai::ThreadPool pool(n);
+    CHECK_EQ(pool.nThreads(), (uint)n, "");
+    double s = rai::parallel_reduce<double>(0, x.N, 0., map, reduce, 1000, pool);
+    if(n==1) s1=s;
+    CHECK_EQ(s, s1, "reduction is not deterministic");
+
+    //parallel_for with per-thread scratch
+    arr y(x.N);
+    rai::WorkerScratch<uint> count(pool);
+    for(uint& c:count.slots) c=0;
+    rai::parallel_for(0, x.N, [&](uint i){ y.elem(i) = 2.*x.elem(i); count()++; }, 0, pool);
+    CHECK_ZERO(maxDiff(y, 2.*x), 1e-10, "");
+    uint total=0;
+    count.forAll([&total](uint c){ total+=c; });
+    CHECK_EQ(total, x.N, "");
+
+    //exceptions are propagated to join
+    bool caught=false;
+    try{
+      rai::TaskGroup group(pool);
+      for(uint i=0;i<10;i++) group.run([i](){ if(i==5) throw std::runtime_error("task failed"); });
+      group.join();
+    }catch(const std::runtime_error&){ caught=true; }
+    CHECK(caught, "");
+  }
+  CHECK_ZERO(s1-sum(x), 1e-6, "");
+
+  //concurrent callers from outside the pool -- plain threads and workers of another pool -- never share a slot
+  rai::ThreadPool pool(3), other(2);
+  rai::WorkerScratch<uint> busy(pool);
+  for(uint& b:busy.slots) b=0;
+  std::atomic<int> overlaps(0);
+  auto work = [&](){
+    rai::parallel_for(0, 2000, [&](uint i){
+      if(busy()++) overlaps++;
+      for(volatile int k=0; k<100; k++);
+      busy()--;
+    }, 1, pool);
+  };
+  std::thread t1(work), t2(work);
+  rai::parallel_for(0, 4, [&](uint){ work(); }, 1, other);
+  t1.join();
+  t2.join();
+  CHECK_EQ(overlaps, 0, "two threads used the same slot");
+
+  //outside threads don't serialize each other: a body may wait for the body of another outside thread
+  std::atomic<int> arrived(0);
+  auto meet = [&](){
+    rai::parallel_for(0, 1, [&](uint){ arrived++; while(arrived<2) std::this_thread::yield(); }, 0, pool);
+  };
+  std::thread t3(meet), t4(meet);
+  t3.join();
+  t4.join();
+}
+
+//===========================================================================
+
+//===========================================================================
+
+void TEST(LockFreeVar){
+  Var<arr> x;
+  x.set() = zeros(1000);
+  x.setLockFree(2);
+
+  //a held read token neither blocks the writer nor sees its modifications
+  {
+    auto r = x.get();
+    x.set(1.) = ones(1000);
+    CHECK_EQ(r->elem(0), 0., "");
+    auto r2 = x.get();
+    CHECK_EQ(r2->elem(0), 1., "");
+    CHECK_EQ(r2.data_time, 1., "");
+  }
+
+  //concurrent single writer: readers only ever see completed writes
+  std::atomic<bool> stop(false);
+  std::thread writer([&x, &stop]() {
+    for(uint k=2; !stop; k++) { auto w = x.set(); w() = double(k); }
+  });
+  int lastRevision = 0;
+  uint reads=0;
+  for(double t=rai::realTime(); rai::realTime()-t<.5;) {
+    auto r = x.get();
+    CHECK_EQ(min(r()), max(r()), "torn read");
+    CHECK_GE(x.last_read_revision, lastRevision, "");
+    lastRevision = x.last_read_revision;
+    reads++;
+  }
+  stop = true;
+  writer.join();
+  cout <<"lock-free reads: " <<reads <<" revision: " <<x.getRevision() <<endl;
+}
+
+//===========================================================================
+
+void TEST(MessageQueue){
+  //drop-oldest keeps the newest messages
+  rai::MessageQueue<int> q(4, rai::QP_dropOldest);
+  for(int i=0; i<10; i++) q.push(i);
+  CHECK_EQ(q.depth(), 4, "");
+  CHECK_EQ(q.dropped, 6, "");
+  int x;
+  for(int i=6; i<10; i++) { CHECK(q.pop(x), ""); CHECK_EQ(x, i, ""); }
+  CHECK(!q.pop(x), "");
+
+  //reject
+  rai::MessageQueue<int> r(2, rai::QP_reject);
+  CHECK(r.push(1) && r.push(2) && !r.push(3), "");
+  CHECK_EQ(r.rejected, 1, "");
+
+  //two producers with backpressure, one blocking consumer: all messages arrive once and in order per producer
+  uint N=20000;
+  rai::MessageQueue<arr> b(8, rai::QP_block);
+  auto produce = [&b, N](double id) { for(uint i=0; i<N; i++) b.push(arr{id, double(i)}); };
+  std::thread p1(produce, 0.), p2(produce, 1.);
+  uintA next = {0, 0};
+  arr m;
+  for(uint k=0; k<2*N; k++) {
+    CHECK(b.pop(m, -1.), "");
+    uint id=m(0);
+    CHECK_EQ(m(1), next(id), "message out of order");
+    next(id)++;
+  }
+  p1.join();
+  p2.join();
+  CHECK_EQ(b.depth(), 0, "");
+  CHECK_EQ(b.dropped+b.rejected, 0, "");
+  b.report(cout);  cout <<endl;
+
+  //a listening thread steps once per message
+  struct Consumer : Thread {
+    rai::MessageQueue<int>& q;
+    int sum=0;
+    Consumer(rai::MessageQueue<int>& _q) : Thread("Consumer"), q(_q) { threadOpen(true); q.listen(event); }
+    ~Consumer() { q.stopListen(event); threadClose(); }
+    void step() { int i; while(q.pop(i)) sum+=i; }
+  };
+  rai::MessageQueue<int> c(16);
+  Consumer consumer(c);
+  for(int i=1; i<=10; i++) c.push(i);
+  for(uint k=0; k<100 && consumer.sum<55; k++) rai::wait(.01);
+  CHECK_EQ(consumer.sum, 55, "");
+}
+
+//===========================================================================
+
+void TEST(Metronome){
+  struct Beat : Thread {
+    uint n=0;
+    double first=0., last=0.;
+    Beat() : Thread("Beat", .002) {}
+    ~Beat() { threadClose(); }
+    void step() { last=rai::realTime(); if(!n) first=last; n++; }
+  } beat;
+  beat.threadLoop();
+  rai::wait(.5);
+  beat.threadStop(true);
+  cout <<beat.report() <<endl;
+  Metronome& m = beat.metronome;
+  CHECK_EQ(m.latency.n, m.tics, "");
+  CHECK_GE(m.tics, 25, "the metronome runs far too slow");
+  CHECK_GE(m.latency.quantile(1.), m.latency.quantile(.5), "");
+  //absolute deadlines: wake-up latencies don't accumulate, so without misses the mean period is the interval
+  if(!m.latency.misses && beat.n>1) {
+    double period = (beat.last-beat.first)/(beat.n-1);
+    cout <<"mean period: " <<period <<"sec" <<endl;
+    CHECK_ZERO(period-.002, 4e-5, "tics drift from the absolute deadlines");
+  }
+  beat.threadClose();
+}
+
+//===========================================================================
+
 int MAIN(int argc,char** argv){
   rai::initCmdLine(argc, argv);
 
@@ -201,6 +382,10 @@ int MAIN(int argc,char** argv){
   testWay0();
   testWay1();
   testLogging();
+  testThreadPool();
+  testLockFreeVar();
+  testMessageQueue();
+  testMetronome();
 
   return 0;
 }
@@ -50,6 +50,22 @@ void TEST(Parameter){
   double d = rai::getParameter<double>("number");
 
   cout <<p1 <<endl <<p2 <<endl <<d <<endl;
+
+  //-- cached lookups are invalidated by modifications of the parameter graph
+  CHECK_EQ(rai::getParameter<double>("cached", 1.), 1., "");
+  CHECK_EQ(rai::getParameter<double>("cached", 2.), 2., "absent parameters must return the current default");
+  rai::setParameter<double>("cached", 3.);
+  CHECK_EQ(rai::getParameter<double>("cached", 1.), 3., "");
+  rai::getParameters()->get<double>("cached") = 4.;
+  CHECK_EQ(rai::getParameter<double>("cached", 1.), 4., "");
+  CHECK_EQ(rai::getParameter<int>("cached", 0), 4, "");
+  uint64_t rev = rai::getParametersRevision();
+  CHECK(rai::readParameters()->findNode("cached"), "");
+  CHECK_EQ(rai::getParametersRevision(), rev, "lookups must not invalidate the caches");
+
+  rai::timerStart();
+  for(uint i=0; i<100000; i++) d = rai::getParameter<double>("number");
+  cout <<"cached getParameter: " <<rai::timerRead()/100000*1e9 <<"ns" <<endl;
 }
 
 void TEST(Wait){
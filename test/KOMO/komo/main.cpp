@@ -4,6 +4,7 @@
 #include <Kin/viewer.h>
 #include <Kin/F_pose.h>
 #include <Optim/MP_Solver.h>
+#include <Optim/lagrangian.h>
 
 #include <thread>
 
@@ -253,6 +254,184 @@ void TEST(Threading) {
 
 //===========================================================================
 
+void TEST(ParallelFeatures){
+  rai::Configuration C("arm.g");
+  KOMO komo;
+  komo.opt.verbose=0;
+  komo.setModel(C);
+  komo.setTiming(1., 20, 5., 2);
+  auto addObjectives = [&komo](FeatureSymbol align){
+    komo.add_qControlObjective({}, 2, 1.);
+    komo.addObjective({1.}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e2});
+    komo.addObjective({.5, 1.}, align, {"endeff", "target"}, OT_sos, {1e1});
+    komo.addObjective({}, FS_accumulatedCollisions, {}, OT_eq, {1e0});
+  };
+  addObjectives(FS_vectorXDiff);
+  komo.run_prepare(.01);
+  shared_ptr<MathematicalProgram> mp = komo.mp_SparseNonFactored();
+
+  //features computed by workers are assembled in objective order: identical to the serial evaluation
+  auto compare = [&](){
+    arr phi1, J1, phi4, J4;
+    komo.opt.featureThreads=1;
+    mp->evaluate(phi1, J1, komo.x);
+    komo.opt.featureThreads=4;
+    mp->evaluate(phi4, J4, komo.x);
+    CHECK(phi1==phi4, "parallel features differ from serial");
+    CHECK(J1.sparse().unsparse()==J4.sparse().unsparse(), "parallel Jacobian differs from serial");
+  };
+  compare();
+  compare(); //reusing the partition
+
+  //other objectives of the same number and dimensions: the partition is rebuilt
+  uint n=komo.objs.N;
+  komo.clearObjectives();
+  addObjectives(FS_vectorZDiff);
+  CHECK_EQ(komo.objs.N, n, "");
+  compare();
+  komo.opt.featureThreads=1;
+}
+
+//===========================================================================
+
+void TEST(ParallelCollisions){
+  rai::Configuration C("arm.g");
+  auto setup = [&C](KOMO& komo, int threads){
+    komo.opt.verbose=0;
+    komo.opt.useFCL=true;
+    komo.opt.collisionThreads=threads;
+    komo.setModel(C, true);
+    komo.setTiming(1., 20, 5., 2);
+    komo.add_qControlObjective({}, 2, 1.);
+    komo.addObjective({}, FS_accumulatedCollisions, {}, OT_eq, {1e0});
+    komo.run_prepare(0.);
+  };
+  KOMO serial, parallel;
+  setup(serial, 1);
+  setup(parallel, 4);
+  CHECK_EQ(parallel.fclWorkers.N, 3, "");
+
+  //clones get their own workers
+  KOMO clone;
+  clone.clone(parallel);
+  CHECK_EQ(clone.fclWorkers.N, 3, "");
+  for(uint w=0; w<3; w++) CHECK(clone.fclWorkers(w)!=parallel.fclWorkers(w), "fcl workers are shared with the clone");
+
+  //the same proxies (in the same order) as the serial queries, over a moving trajectory
+  arr x = serial.x;
+  for(uint k=0; k<5; k++) {
+    rndGauss(x, .3, true);
+    for(KOMO* komo: {&parallel, &clone}) {
+      serial.set_x(x);
+      komo->set_x(x);
+      ProxyA& P1 = serial.pathConfig.proxies;
+      ProxyA& P2 = komo->pathConfig.proxies;
+      CHECK_EQ(P1.N, P2.N, "parallel collision queries found other proxies");
+      for(uint i=0; i<P1.N; i++) CHECK(P1(i).a->ID==P2(i).a->ID && P1(i).b->ID==P2(i).b->ID, "proxy " <<i <<" differs");
+    }
+  }
+}
+
+//===========================================================================
+
+void TEST(JacobianPattern){
+  rai::Configuration C("arm.g");
+  KOMO komo;
+  komo.opt.verbose=0;
+  komo.setModel(C);
+  komo.setTiming(1., 20, 5., 2);
+  auto addObjectives = [&komo](const char* frame){
+    komo.add_qControlObjective({}, 2, 1.);
+    komo.addObjective({.5, 1.}, FS_positionDiff, {frame, "target"}, OT_eq, {1e1});
+  };
+  addObjectives("endeff");
+  komo.run_prepare(.01);
+  shared_ptr<MathematicalProgram> mp = komo.mp_SparseNonFactored();
+
+  //J filled into the pattern equals J merged without pattern
+  auto evaluate = [&](){
+    arr phi0, J0, phi, J;
+    komo.opt.sparseJacobianPattern=false;
+    mp->evaluate(phi0, J0, komo.x);
+    komo.opt.sparseJacobianPattern=true;
+    mp->evaluate(phi, J, komo.x);
+    CHECK(phi==phi0, "");
+    CHECK(J.sparse().unsparse()==J0.sparse().unsparse(), "Jacobian filled into the pattern differs");
+  };
+
+  evaluate();
+  CHECK_EQ(komo.jacobianPatternBuilds, 1, "");
+  for(uint k=0; k<3; k++) {
+    rndGauss(komo.x, .1, true);
+    evaluate();
+  }
+  CHECK_EQ(komo.jacobianPatternBuilds, 1, "the pattern is not reused across evaluations");
+
+  //other objectives of the same dimensions, on a frame with another Jacobian structure
+  uint n=komo.objs.N;
+  komo.clearObjectives();
+  addObjectives("arm3");
+  CHECK_EQ(komo.objs.N, n, "");
+  evaluate();
+  CHECK_EQ(komo.jacobianPatternBuilds, 2, "the pattern is not rebuilt for changed objectives");
+  evaluate();
+  CHECK_EQ(komo.jacobianPatternBuilds, 2, "");
+
+  //collision features: the frames in their Jacobians change with the configuration
+  komo.addObjective({}, FS_accumulatedCollisions, {}, OT_eq, {1e0});
+  mp = komo.mp_SparseNonFactored();
+  for(uint k=0; k<10; k++) {
+    rndGauss(komo.x, .5, true);
+    evaluate();
+  }
+}
+
+//===========================================================================
+
+void TEST(BandedNewton){
+  rai::Configuration C("arm.g");
+  KOMO komo;
+  komo.opt.verbose=0;
+  komo.setModel(C);
+  komo.setTiming(1., 10, 5., 2);
+  komo.add_qControlObjective({}, 2, 1.);
+  komo.addObjective({1.}, FS_positionDiff, {"endeff", "target"}, OT_eq, {1e1});
+  komo.run_prepare(.01);
+  arr x0 = komo.x;
+  double beta = 1e-1;
+
+  //the Newton step of KS_banded: RowShifted Hessian, damped on the packed diagonal and solved with banded_LDLT
+  arr g, H;
+  LagrangianProblem L(komo.mp_Banded());
+  L.lagrangian(g, H, x0);
+  CHECK(isRowShifted(H), "KS_banded does not yield a banded Hessian");
+  arr Hdense = unpack(H);
+  for(uint i=0; i<H.d0; i++) H.rowShifted().entry(i, 0) += beta;
+  arr Delta = lapack_Ainv_b_sym(H, -g);
+
+  //the same step from the dense problem
+  arr g0, H0;
+  komo.solver = rai::KS_dense;
+  LagrangianProblem L0(komo.mp_SparseNonFactored());
+  L0.lagrangian(g0, H0, x0);
+  CHECK_ZERO(maxDiff(g, g0), 1e-8, "");
+  CHECK_ZERO(maxDiff(Hdense, H0), 1e-8, "");
+  for(uint i=0; i<H0.d0; i++) H0(i, i) += beta;
+  arr Delta0 = lapack_Ainv_b_sym(H0, -g0);
+  CHECK_ZERO(maxDiff(Delta, Delta0), 1e-6, "banded Newton step differs from the dense one");
+
+  //full solves from the same initialization
+  komo.solver = rai::KS_banded;
+  komo.run();
+  arr x = komo.x;
+  komo.x = x0;
+  komo.solver = rai::KS_dense;
+  komo.run();
+  CHECK_ZERO(maxDiff(x, komo.x), 1e-3, "banded and dense solves disagree");
+}
+
+//===========================================================================
+
 int main(int argc,char** argv){
   rai::initCmdLine(argc,argv);
 
@@ -263,6 +442,10 @@ int main(int argc,char** argv){
   testThin();
   testPR2();
   testThreading();
+  testJacobianPattern();
+  testBandedNewton();
+  testParallelFeatures();
+  testParallelCollisions();
 
   return 0;
 }
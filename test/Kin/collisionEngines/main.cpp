@@ -3,6 +3,7 @@
 #include <Gui/opengl.h>
 #include <Kin/frame.h>
 #include <Kin/viewer.h>
+#include <Geo/fclInterface.h>
 
 void TEST(Swift) {
   rai::Configuration C("swift_test.g");
@@ -104,11 +105,46 @@ void TEST(CollisionTiming){
   cout <<" query time: " <<rai::timerRead(true) <<"sec" <<endl;
 }
 
+void TEST(IncrementalBroadphase){
+  rai::Configuration C;
+  uint n=100;
+  for(uint i=0;i<n;i++){
+    rai::Frame *a = C.addFrame(STRING("obj_i"<<i));
+    a->setPose(rai::Transformation().setRandom());
+    a->set_X()->pos *= 2.;
+    a->setConvexMesh(.2*rai::Mesh().setRandom().V, {}, .02);
+    a->setContact(1);
+  }
+  rai::Array<ptr<rai::Mesh>> geometries(C.frames.N);
+  for(rai::Frame* f:C.frames) geometries(f->ID) = f->shape->_mesh;
+
+  auto sortedPairs = [](uintA P){
+    for(uint i=0;i<P.d0;i++) if(P(i,0)>P(i,1)) std::swap(P(i,0), P(i,1));
+    std::sort((std::pair<uint,uint>*)P.p, (std::pair<uint,uint>*)P.p+P.d0);
+    return P;
+  };
+
+  //the incremental sort-and-sweep gives the same pairs as fcl's broadphase, over a coherent motion where some objects rest
+  for(double cutoff:{-1., 0.}){ //broadphase candidates only, and fine collisions
+    rai::FclInterface full(geometries, cutoff), incr(geometries, cutoff);
+    incr.incremental=true;
+    arr X = C.getFrameState();
+    for(uint t=0;t<20;t++){
+      for(uint i=0;i<X.d0;i++) if(rnd.uni()<.7) for(uint j=0;j<3;j++) X(i,j) += .05*rnd.gauss();
+      full.step(X);
+      incr.step(X);
+      cout <<"cutoff " <<cutoff <<" step " <<t <<": " <<full.collisions.d0 <<" pairs" <<endl;
+      CHECK(sortedPairs(full.collisions)==sortedPairs(incr.collisions), "incremental sort-and-sweep differs from fcl's broadphase at step " <<t);
+    }
+  }
+}
+
 int MAIN(int argc, char** argv){
   rai::initCmdLine(argc, argv);
 
 //  testSwift();
 //  testFCL();
+  testIncrementalBroadphase();
   testCollisionTiming();
 
   return 0;
@@ -11,6 +11,8 @@
 #include <Optim/optimization.h>
 #include <Kin/feature.h>
 
+#include <dirent.h>
+
 //===========================================================================
 //
 // test load save
@@ -198,6 +200,154 @@ void TEST(Copy){
 
   CHECK_EQ(g1, g2, "copy operator failed!")
   cout <<"** copy operator success" <<endl;
+
+  //meshes are shared until modified
+  rai::Frame *f1=0, *f2=0;
+  for(rai::Frame* f:G1.frames) if(f->shape && f->shape->_mesh) { f1=f; f2=G2.frames(f->ID); break; }
+  if(f1) {
+    CHECK_EQ(f1->shape->_mesh, f2->shape->_mesh, "");
+    arr col = f1->shape->mesh().C;
+    f2->setColor({1., 0., 0.});
+    CHECK(f1->shape->_mesh!=f2->shape->_mesh, "");
+    CHECK_EQ(f1->shape->mesh().C, col, "modifying the copy changed the original");
+
+    //an unshared mesh is modified in place, also after the collision models referred to it
+    rai::Mesh* m2 = f2->shape->_mesh.get();
+    G2.fcl();
+    f2->setColor({0., 1., 0.});
+    CHECK_EQ(f2->shape->_mesh.get(), m2, "");
+  }
+}
+
+//===========================================================================
+//
+// frame name lookup
+//
+
+void TEST(FrameNames){
+  rai::Configuration C("kinematicTests.g");
+  for(rai::Frame* f:C.frames) if(f->name.N) CHECK_EQ(C.getFrame(f->name)->name, f->name, "");
+
+  //duplicate names (as in time slices) are found in ID order
+  rai::Frame* a = C.addFrame("dup");
+  rai::Frame* b = C.addFrame("dup");
+  CHECK_EQ(C.getFrame("dup"), a, "");
+  CHECK_EQ(C.getFrame("dup", true, true), b, "");
+
+  //renamed and deleted frames
+  a->setName("renamed");
+  CHECK_EQ(C.getFrame("renamed"), a, "");
+  CHECK_EQ(C.getFrame("dup"), b, "");
+  b->name = "direct"; //without setName: found by the fallback scan
+  CHECK_EQ(C.getFrame("direct"), b, "");
+  b->setName("dup");
+
+  //renaming a lower-ID frame to the name of an indexed higher-ID frame
+  rai::Frame* c = C.addFrame("high");
+  CHECK_EQ(C.getFrame("high"), c, "");
+  a->setName("high");
+  CHECK_EQ(C.getFrame("high"), a, "");
+  CHECK_EQ(C.getFrame("high", true, true), c, "");
+  CHECK(!C.getFrame("renamed", false), "");
+  delete a;
+  CHECK_EQ(C.getFrame("high"), c, "");
+  CHECK_EQ(C.getFrame("high", true, true), c, "");
+
+  //deleting a frame renamed without setName
+  rai::Frame* d = C.addFrame("d");
+  rai::Frame* e = C.addFrame("e");
+  CHECK_EQ(C.getFrame("e"), e, "");
+  d->name = "d2";
+  delete d;
+  CHECK(!C.getFrame("d", false) && !C.getFrame("d2", false), "");
+  CHECK_EQ(C.getFrame("e"), e, "");
+  C.prefixNames();
+  CHECK_EQ(C.getFrame(STRING('_' <<b->ID <<"_dup")), b, "");
+}
+
+//===========================================================================
+//
+// mesh cache
+//
+
+void forEachCacheEntry(const char* dir, std::function<void(const char*)> f){
+  DIR* d = opendir(dir);
+  if(!d) return;
+  for(dirent* e; (e=readdir(d));) if(e->d_name[0]!='.') f(STRING(dir <<'/' <<e->d_name));
+  closedir(d);
+}
+
+void TEST(MeshCache){
+  rai::String cacheHome = STRING(rai::getcwd_string() <<"/z.cache");
+  rai::system(STRING("rm -rf " <<cacheHome));
+  setenv("XDG_CACHE_HOME", cacheHome, 1);
+  rai::String meshes = rai::cachePath("meshes");
+  uint n;
+  auto countEntries = [&](){ n=0; forEachCacheEntry(meshes, [&](const char*){ n++; }); return n; };
+
+  FILE("z.mesh.g") <<"pin { shape:mesh, mesh:'z.mesh.off' }";
+  rai::Mesh M;
+  M.readFile("pin1.off");
+  M.writeOffFile("z.mesh.off");
+
+  //cold: loads the file and writes the entry; warm: maps it
+  double t=rai::cpuTime();
+  rai::Configuration C1("z.mesh.g");
+  double tCold=rai::cpuTime()-t;
+  CHECK_EQ(countEntries(), 1, "");
+  t=rai::cpuTime();
+  rai::Configuration C2("z.mesh.g");
+  double tWarm=rai::cpuTime()-t;
+  cout <<"mesh load cold: " <<tCold <<"sec warm: " <<tWarm <<"sec" <<endl;
+  rai::Mesh& M1 = C1["pin"]->shape->mesh();
+  rai::Mesh& M2 = C2["pin"]->shape->mesh();
+  CHECK_EQ(countEntries(), 1, "");
+  CHECK_ZERO(maxDiff(M1.V, M2.V), 0., "");
+  CHECK(M1.T==M2.T, "");
+
+  //editing the source gives a new entry
+  M.scale(2.);
+  M.writeOffFile("z.mesh.off");
+  rai::Configuration C3("z.mesh.g");
+  rai::Mesh& M3 = C3["pin"]->shape->mesh();
+  CHECK_EQ(countEntries(), 2, "");
+  CHECK_ZERO(maxDiff(M3.V, 2.*M1.V), 1e-6, "");
+
+  //corrupt entries are removed and the mesh is loaded from the file
+  forEachCacheEntry(meshes, [](const char* entry){ FILE(STRING(entry <<"/info.arr")) <<"garbage"; });
+  rai::Configuration C4("z.mesh.g");
+  CHECK_ZERO(maxDiff(C4["pin"]->shape->mesh().V, M3.V), 0., "");
+  CHECK_EQ(countEntries(), 2, "corrupt entry was not replaced");
+  rai::Configuration C5("z.mesh.g");
+  CHECK_ZERO(maxDiff(C5["pin"]->shape->mesh().V, M3.V), 0., "");
+}
+
+//===========================================================================
+
+void TEST(KinematicsBatch){
+  rai::Configuration C("kinematicTests.g");
+  arr q0 = C.getJointState();
+  arr Q = q0 + .3*randn(20, q0.N);
+  FrameL F = C.frames({1, -1});
+
+  arr X, Jpos, Jang;
+  C.kinematicsBatch(X, Jpos, Jang, Q, F);
+  CHECK_EQ(maxDiff(C.getJointState(), q0), 0., "the state must not change");
+
+  //compare against setting each joint state
+  for(uint s=0; s<Q.d0; s++) {
+    C.setJointState(Q[s]);
+    for(uint i=0; i<F.N; i++) {
+      arr y, J;
+      CHECK_ZERO(maxDiff(X[s][i]({0, 2}), F(i)->getPosition()), 1e-10, "");
+      arr rot = X[s][i]({3, 6}), rot_i = F(i)->getQuaternion();
+      CHECK_ZERO(rai::MIN(maxDiff(rot, rot_i), maxDiff(-rot, rot_i)), 1e-10, "");
+      C.jacobian_pos(J, F(i), F(i)->ensure_X().pos);
+      CHECK_ZERO(maxDiff(Jpos[s][i], J), 1e-10, "");
+      C.jacobian_angular(J, F(i));
+      CHECK_ZERO(maxDiff(Jang[s][i], J), 1e-10, "");
+    }
+  }
 }
 
 //===========================================================================
@@ -647,6 +797,9 @@ int MAIN(int argc,char **argv){
 
   testLoadSave();
   testCopy();
+  testFrameNames();
+  testMeshCache();
+  testKinematicsBatch();
   testGraph();
   testPlayStateSequence();
   testViewerUpdate();
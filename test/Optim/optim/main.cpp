@@ -3,6 +3,7 @@
 #include <functional>
 #include <Optim/MP_Solver.h>
 #include <Optim/lagrangian.h>
+#include <Optim/sparseLDL.h>
 
 //===========================================================================
 
@@ -45,11 +46,37 @@ void TEST(Solver) {
 
 //===========================================================================
 
+void TEST(SparseLDL) {
+  //banded Gauss-Newton Hessian H = J^T J + I, as in path optimization
+  uint n=300, band=6;
+  arr J, H, I;
+  J.sparse().resize(2*n, n, 0);
+  for(uint i=0; i<2*n; i++) for(uint j=i/2; j<rai::MIN(n, i/2+band); j++) J.sparse().addEntry(i, j) = rnd.gauss();
+  I.sparse().resize(n, n, 0);
+  for(uint i=0; i<n; i++) I.sparse().addEntry(i, i) = 1.;
+
+  SparseLDL ldl;
+  for(uint k=0; k<3; k++) {
+    J.sparse().memRef() *= 1.1;
+    H = J.sparse().At_A();
+    H.sparse().add(I);
+    arr b = randn(n);
+    arr x = ldl.Ainv_b(H, b);
+    CHECK_ZERO(maxDiff(H.sparse().A_x(x), b), 1e-8, "");
+  }
+  CHECK_EQ(ldl.analyses, 1, "the symbolic analysis should be reused for the same pattern");
+  CHECK_EQ(ldl.factorizations, 3, "");
+  cout <<"nnz(H)=" <<H.N <<" nnz(L)=" <<ldl.Lrow.N <<endl;
+}
+
+//===========================================================================
+
 int MAIN(int argc,char** argv){
   rai::initCmdLine(argc,argv);
 
   rnd.clockSeed();
 
+  testSparseLDL();
   testDisplay();
   testSolver();
 